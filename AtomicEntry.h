@@ -0,0 +1,42 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+using namespace std;
+
+
+/*
+* Table entry shared by several threads without locks, 16 bytes
+* It keeps key ^ data next to data, so an entry torn by two threads writing at once fails the key check
+* and reads as a miss; relaxed loads and stores are enough for that
+*/
+struct AtomicEntry
+{
+	atomic<uint64_t> check;	// key ^ data
+	atomic<uint64_t> data;
+
+	// Whether the entry holds key, data is read either way
+	bool Load(uint64_t key, uint64_t& data) const
+	{
+		data = this->data.load(memory_order_relaxed);
+		return (check.load(memory_order_relaxed) ^ data) == key;
+	}
+	void Store(uint64_t key, uint64_t data)
+	{
+		check.store(key ^ data, memory_order_relaxed);
+		this->data.store(data, memory_order_relaxed);
+	}
+	// data without the key check, e.g. to see how full a table is
+	uint64_t GetData() const
+	{
+		return data.load(memory_order_relaxed);
+	}
+
+	void Clear()
+	{
+		check.store(0, memory_order_relaxed);
+		data.store(0, memory_order_relaxed);
+	}
+};
+static_assert(sizeof(AtomicEntry) == 16, "an entry is two 64-bit words");
\ No newline at end of file
@@ -0,0 +1,277 @@
+#pragma once
+
+#include <array>
+
+#if defined(__BMI2__) && !defined(USE_PEXT)
+#	define USE_PEXT
+#endif
+#ifdef USE_PEXT
+#	include <immintrin.h>
+#endif
+
+#include "Coords.h"
+#include "Other.h"
+#include "Bitboard.h"
+
+
+/*
+* Precomputed attack sets
+* Knight, king and pawn tables are built at compile time, the rest by InitAttacks()
+* which must be called before they are used (ChessPosition does it)
+* Sliders use magic bitboards, or PEXT when USE_PEXT is defined (CPUs with BMI2)
+*/
+
+// Squares reached from square by the steps {dx, dy} without leaving the board
+constexpr Bitboard LeaperAttacks(int square, const int (*steps)[2], int count)
+{
+	Bitboard res = 0;
+	int x = square % 8, y = square / 8;
+	for (int i = 0; i < count; i++)
+	{
+		int nx = x + steps[i][0], ny = y + steps[i][1];
+		if (nx >= 0 && nx < 8 && ny >= 0 && ny < 8)
+			res |= 1ULL << (ny * 8 + nx);
+	}
+	return res;
+}
+constexpr array<Bitboard, 64> LeaperTable(const int (*steps)[2], int count)
+{
+	array<Bitboard, 64> res = {};
+	for (int sq = 0; sq < 64; sq++)
+		res[sq] = LeaperAttacks(sq, steps, count);
+	return res;
+}
+
+constexpr int KNIGHT_STEPS[8][2] = { {1, -2}, {2, -1}, {2, 1}, {1, 2}, {-1, 2}, {-2, 1}, {-2, -1}, {-1, -2} };
+constexpr int KING_STEPS[8][2] = { {-1, 0}, {-1, 1}, {0, 1}, {1, 1}, {1, 0}, {1, -1}, {0, -1}, {-1, -1} };
+constexpr int PAWN_STEPS[2][2][2] = { { {-1, 1}, {1, 1} }, { {-1, -1}, {1, -1} } }; // [team]
+
+constexpr array<Bitboard, 64> KNIGHT_ATTACKS = LeaperTable(KNIGHT_STEPS, 8);
+constexpr array<Bitboard, 64> KING_ATTACKS = LeaperTable(KING_STEPS, 8);
+constexpr array<Bitboard, 64> PAWN_ATTACKS[2] = {	// [team][square]
+	LeaperTable(PAWN_STEPS[(int)PlayerTeam::White], 2),
+	LeaperTable(PAWN_STEPS[(int)PlayerTeam::Black], 2)
+};
+
+static_assert(KNIGHT_ATTACKS[0] == 0x20400ULL && KING_ATTACKS[63] == 0x40C0000000000000ULL, "wrong leaper tables");
+static_assert(PAWN_ATTACKS[(int)PlayerTeam::White][8] == 0x20000ULL && PAWN_ATTACKS[(int)PlayerTeam::Black][15] == 0x40ULL, "wrong pawn tables");
+
+
+Bitboard BETWEEN[64][64];		// squares strictly between two aligned squares
+Bitboard LINE[64][64];			// whole line through two aligned squares
+
+
+bool OnBoard(Position pos)
+{
+	return (pos.x >= 0 && pos.x < 8) && (pos.y >= 0 && pos.y < 8);
+}
+
+const Position BISHOP_DIRECTIONS[] = { {1, 1}, {-1, -1}, {-1, 1}, {1, -1} };
+const Position ROOK_DIRECTIONS[] = { {1, 0}, {-1, 0}, {0, 1}, {0, -1} };
+
+// Walks the rays square by square, used to fill and verify the magic tables
+Bitboard SlidingAttacks(int square, Bitboard occupied, const Position* directions)
+{
+	Bitboard res = EMPTY_BB;
+	for (int d = 0; d < 4; d++)
+		for (Position pos = FromSquare(square) + directions[d]; OnBoard(pos); pos += directions[d])
+		{
+			res |= SquareBB(pos);
+			if (HasSquare(occupied, pos))
+				break;
+		}
+	return res;
+}
+
+
+struct Magic
+{
+	Bitboard mask;		// squares that can block the rays, board edges excluded
+	Bitboard magic;
+	Bitboard* attacks;	// this square's part of the attack table
+	int shift;
+
+	unsigned Index(Bitboard occupied) const
+	{
+#ifdef USE_PEXT
+		return (unsigned)_pext_u64(occupied, mask);
+#else
+		return (unsigned)(((occupied & mask) * magic) >> shift);
+#endif
+	}
+};
+
+Magic BISHOP_MAGICS[64];
+Magic ROOK_MAGICS[64];
+
+Bitboard BISHOP_TABLE[0x1480];	// sum of 2^(mask size) over all squares
+Bitboard ROOK_TABLE[0x19000];
+
+Bitboard BishopAttacks(int square, Bitboard occupied)
+{
+	const Magic& m = BISHOP_MAGICS[square];
+	return m.attacks[m.Index(occupied)];
+}
+Bitboard RookAttacks(int square, Bitboard occupied)
+{
+	const Magic& m = ROOK_MAGICS[square];
+	return m.attacks[m.Index(occupied)];
+}
+Bitboard QueenAttacks(int square, Bitboard occupied)
+{
+	return BishopAttacks(square, occupied) | RookAttacks(square, occupied);
+}
+
+Bitboard KnightAttacks(int square)
+{
+	return KNIGHT_ATTACKS[square];
+}
+Bitboard KingAttacks(int square)
+{
+	return KING_ATTACKS[square];
+}
+Bitboard PawnAttacks(PlayerTeam team, int square)
+{
+	return PAWN_ATTACKS[(int)team][square];
+}
+
+Bitboard PieceAttacks(PieceType type, PlayerTeam team, int square, Bitboard occupied)
+{
+	switch (type)
+	{
+	case PieceType::Pawn: return PawnAttacks(team, square);
+	case PieceType::Knight: return KnightAttacks(square);
+	case PieceType::Bishop: return BishopAttacks(square, occupied);
+	case PieceType::Rook: return RookAttacks(square, occupied);
+	case PieceType::Queen: return QueenAttacks(square, occupied);
+	case PieceType::King: return KingAttacks(square);
+	case PieceType::Count: break; // no piece, attacks nothing
+	}
+	return EMPTY_BB;
+}
+
+/*
+* Finds a magic for every square by trial and error and fills the table
+* Fixed seeds (one per rank, they find magics quickly), so the magics are the same on every run
+*/
+void InitMagics(Magic* magics, Bitboard* table, const Position* directions)
+{
+	const Bitboard rank1 = 0xFFULL, rank8 = rank1 << 56;
+	const Bitboard fileA = 0x0101010101010101ULL, fileH = fileA << 7;
+
+	Bitboard occupancy[4096], reference[4096];
+	int epoch[4096] = {}, curEpoch = 0;
+
+	const uint64_t seeds[8] = { 728, 10316, 55013, 32803, 12281, 15100, 16645, 255 };
+	uint64_t seed;
+	auto random = [&]()
+	{
+		seed ^= seed >> 12, seed ^= seed << 25, seed ^= seed >> 27;
+		return seed * 2685821657736338717ULL;
+	};
+
+	for (int sq = 0; sq < 64; sq++)
+	{
+		Magic& m = magics[sq];
+		seed = seeds[sq / 8];
+
+		Bitboard edges = ((rank1 | rank8) & ~(rank1 << (8 * (sq / 8)))) | ((fileA | fileH) & ~(fileA << (sq % 8)));
+		m.mask = SlidingAttacks(sq, EMPTY_BB, directions) & ~edges;
+		m.shift = 64 - PopCount(m.mask);
+		m.attacks = (sq == 0 ? table : magics[sq - 1].attacks + (1ULL << (64 - magics[sq - 1].shift)));
+
+		// every subset of the mask (Carry-Rippler)
+		int size = 0;
+		Bitboard b = EMPTY_BB;
+		do
+		{
+			occupancy[size] = b;
+			reference[size] = SlidingAttacks(sq, b, directions);
+#ifdef USE_PEXT
+			m.attacks[_pext_u64(b, m.mask)] = reference[size];
+#endif
+			size++;
+			b = (b - m.mask) & m.mask;
+		} while (b);
+
+#ifndef USE_PEXT
+		for (int i = 0; i < size;)
+		{
+			m.magic = EMPTY_BB;
+			while (PopCount((m.magic * m.mask) >> 56) < 6)
+				m.magic = random() & random() & random(); // few bits set
+
+			curEpoch++;
+			for (i = 0; i < size; i++)
+			{
+				unsigned idx = m.Index(occupancy[i]);
+				if (epoch[idx] < curEpoch)
+				{
+					epoch[idx] = curEpoch;
+					m.attacks[idx] = reference[i];
+				}
+				else if (m.attacks[idx] != reference[i])
+					break; // collision, try another magic
+			}
+		}
+#endif
+	}
+}
+
+// Compares every table entry against the ray walk
+bool CheckSliderAttacks()
+{
+	for (int sq = 0; sq < 64; sq++)
+	{
+		Bitboard b = EMPTY_BB;
+		do
+		{
+			if (BishopAttacks(sq, b) != SlidingAttacks(sq, b, BISHOP_DIRECTIONS))
+				return false;
+			b = (b - BISHOP_MAGICS[sq].mask) & BISHOP_MAGICS[sq].mask;
+		} while (b);
+
+		b = EMPTY_BB;
+		do
+		{
+			if (RookAttacks(sq, b) != SlidingAttacks(sq, b, ROOK_DIRECTIONS))
+				return false;
+			b = (b - ROOK_MAGICS[sq].mask) & ROOK_MAGICS[sq].mask;
+		} while (b);
+	}
+	return true;
+}
+
+bool BuildAttacks()
+{
+	for (int a = 0; a < 64; a++)
+		for (int b = 0; b < 64; b++)
+		{
+			BETWEEN[a][b] = LINE[a][b] = EMPTY_BB;
+			if (a == b) continue;
+
+			const Position* directions = nullptr;
+			if (HasSquare(SlidingAttacks(a, EMPTY_BB, BISHOP_DIRECTIONS), b))
+				directions = BISHOP_DIRECTIONS;
+			else if (HasSquare(SlidingAttacks(a, EMPTY_BB, ROOK_DIRECTIONS), b))
+				directions = ROOK_DIRECTIONS;
+			else continue;
+
+			BETWEEN[a][b] = SlidingAttacks(a, SquareBB(b), directions) & SlidingAttacks(b, SquareBB(a), directions);
+			LINE[a][b] = (SlidingAttacks(a, EMPTY_BB, directions) & SlidingAttacks(b, EMPTY_BB, directions)) | SquareBB(a) | SquareBB(b);
+		}
+
+	InitMagics(BISHOP_MAGICS, BISHOP_TABLE, BISHOP_DIRECTIONS);
+	InitMagics(ROOK_MAGICS, ROOK_TABLE, ROOK_DIRECTIONS);
+	// checked in every build, a wrong magic would silently corrupt move generation
+	if (!CheckSliderAttacks())
+		throw "Wrong slider attack tables";
+
+	return true;
+}
+
+void InitAttacks()
+{
+	static const bool initialized = BuildAttacks(); // thread-safe, runs once
+	(void)initialized;
+}
\ No newline at end of file
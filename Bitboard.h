@@ -0,0 +1,69 @@
+#pragma once
+
+#include <bit>
+#include <cstdint>
+
+#include "Coords.h"
+
+using namespace std;
+
+
+/*
+* Set of squares, bit i is square (i % 8, i / 8)
+* a1 = 0, b1 = 1, ..., h8 = 63
+*/
+typedef uint64_t Bitboard;
+
+const Bitboard EMPTY_BB = 0;
+const Bitboard FULL_BB = ~0ULL;
+
+int ToSquare(Position pos)
+{
+	return pos.y * 8 + pos.x;
+}
+Position FromSquare(int square)
+{
+	return Position(square % 8, square / 8);
+}
+
+Bitboard SquareBB(int square)
+{
+	return 1ULL << square;
+}
+Bitboard SquareBB(Position pos)
+{
+	return SquareBB(ToSquare(pos));
+}
+
+bool HasSquare(Bitboard bb, int square)
+{
+	return (bb >> square) & 1;
+}
+bool HasSquare(Bitboard bb, Position pos)
+{
+	return HasSquare(bb, ToSquare(pos));
+}
+
+Bitboard FileBB(int square) // squares on the file of square
+{
+	return 0x0101010101010101ULL << (square % 8);
+}
+Bitboard RankBB(int square) // squares on the rank of square
+{
+	return 0xFFULL << (8 * (square / 8));
+}
+
+int PopCount(Bitboard bb)
+{
+	return popcount(bb);
+}
+int LowestSquare(Bitboard bb) // bb must not be empty
+{
+	return countr_zero(bb);
+}
+int PopLowestSquare(Bitboard& bb) // bb must not be empty
+{
+	int square = LowestSquare(bb);
+	bb &= bb - 1;
+	return square;
+}
\ No newline at end of file
@@ -1,13 +1,17 @@
 #pragma once
 
-#include <map>
 #include <string>
 #include <cassert>
 
 #include "Coords.h"
 #include "Other.h"
+#include "Bitboard.h"
+#include "ChessPosition.h"
+#include "Evaluation.h"
+#include "PackedMove.h"
 #include "PieceMove.h"
 #include "Piece.h"
+#include "NotationTable.h"
 
 
 
@@ -36,21 +40,22 @@ struct TimeControl
 
 class ChessBoard
 {
-	vector<vector<Piece*> > grid;
-
-	int turnsWithoutCapture;			// for 50-move rule
-	map<string, int> prevBoards;		// for 3-fold repetition
+	vector<vector<Piece*> > grid;		// owns the pieces, mirrors position for the GUI
+	ChessPosition position;				// the position itself, moves are made with DoMove/UndoMove
 	
 	int curMoveInd;						// index of a move on a grid, -1 on the first move
 	vector<PieceMove> moves;			// record of all moves
+	mutable vector<int> notations;		// NotationTable index of every move's notation, -1 until it is asked for
+
+	static const int KEYFRAME_INTERVAL = 16;
+	vector<BoardState> keyframes;		// position after every KEYFRAME_INTERVAL plies of moves, starting with ply 0
+	vector<ChessPosition::UndoInfo> history;	// undo record of every move, so position can be set to any ply with its past
 
-	PlayerTeam curTurn;					// turn on the board
 	PlayerTeam realTurn;				// turn not considering moveBackwards
 	
-	vector<vector<bool> > visibleByWhite;
-	vector<vector<bool> > visibleByBlack;
-
-	GameState state;
+	// legal moves and state are worked out when asked for and kept until the position changes
+	mutable GameState state;
+	mutable bool stateUpToDate;
 
 
 	bool withoutTime;
@@ -59,253 +64,62 @@ class ChessBoard
 	int remainingTimeBlack;	// in seconds
 
 
-	struct TestMoveData
-	{
-		Position from;
-		Position to;
-
-		Piece* removedPiece;
-
-		TestMoveData() :
-			from(), to(), removedPiece(nullptr)
-		{}
-		TestMoveData(Position from, Position to, Piece* removedPiece) :
-			from(from), to(to), removedPiece(removedPiece)
-		{}
-	};
-	TestMoveData TestMove(Position from, Position to)
-	{
-		Piece* p = grid[from.y][from.x];
-
-		p->SetPosition(to);
-
-		grid[from.y][from.x] = nullptr;
-
-		TestMoveData data(from, to, grid[to.y][to.x]);
-		grid[to.y][to.x] = p;
-
-		UpdatePieces();
-
-		return data;
-	}
-	void ReverseTestMove(TestMoveData data)
-	{
-		grid[data.from.y][data.from.x] = grid[data.to.y][data.to.x];
-		grid[data.to.y][data.to.x] = data.removedPiece;
-
-		grid[data.from.y][data.from.x]->SetPosition(data.from);
-
-		UpdatePieces();
-	}
-
-
-	void UpdatePieces()
-	{
-		for (int i = 0; i < SIZE.y; i++)
-			for (int j = 0; j < SIZE.x; j++)
-			{
-				visibleByWhite[i][j] = false;
-				visibleByBlack[i][j] = false;
-			}
-
-		for (int i = 0; i < SIZE.y; i++)
-			for (int j = 0; j < SIZE.x; j++)
-				if (!IsEmpty({ j, i }))
-				{
-					grid[i][j]->Update();
-
-					auto& visible = (grid[i][j]->GetTeam() == PlayerTeam::White ? visibleByWhite : visibleByBlack);
-					const vector<Position>& visibleByPiece = grid[i][j]->GetVisible();
-
-					for (const Position& p : visibleByPiece)
-						visible[p.y][p.x] = true;
-				}
-	}
-
-	map<Piece*, vector<Position> > legalMoves;
-	void AddEnPassant()
+	mutable MoveList legalMoves;
+	mutable bool legalMovesUpToDate;
+	// Checks, mates and legal moves all need the king of the side to move
+	void RequireKing() const
 	{
-		if (!moves.empty())
-		{
-			PieceMove lastMove = GetLastMove();
-			if (lastMove.piece->GetType() == PieceType::Pawn &&
-				lastMove.type == PieceMove::MoveType::Move &&
-				abs(lastMove.to.y - lastMove.from.y) == 2)
-			{
-				auto CheckAndPush = [&](Position pos)
-				{
-					if (InBounds(pos) && !IsEmpty(pos) && GetType(pos) == PieceType::Pawn && GetTeam(pos) == curTurn)
-					{
-						Piece* p = _GetPieceAt(pos);
-
-						Position newPos(lastMove.from.x, (lastMove.from.y + lastMove.to.y) / 2);
-
-						auto r = TestMove(p->GetPosition(), newPos);
-
-						if (!IsCheck())
-							legalMoves[p].push_back(newPos);
-
-						ReverseTestMove(r);
-					}
-				};
-
-				CheckAndPush(lastMove.to + Position(1, 0));
-				CheckAndPush(lastMove.to - Position(1, 0));
-			}
-		}
-	}
-	void AddCastles()
-	{
-		if (IsCheck()) return;
-
-		Piece* king = nullptr;
-		Piece* leftRook = nullptr;
-		Piece* rightRook = nullptr;
-
-		for (int i = 0; i < SIZE.y; i++)
-			for (int j = 0; j < SIZE.x; j++)
-				if (!IsEmpty({ j, i }) && GetTeam({ j, i }) == curTurn)
-				{
-					if (GetType({ j, i }) == PieceType::King)
-						king = grid[i][j];
-
-					if (GetType({ j, i }) == PieceType::Rook)
-						(leftRook == nullptr ? leftRook : rightRook) = grid[i][j];
-				}
-
-		if (king == nullptr)
+		if (position.GetKingSquare(GetTurn()) == -1)
 			throw "King not found";
-
-		if (king->HasMoved())
-			return;
-
-		if (leftRook == nullptr && rightRook == nullptr)
-			return;
-
-		if (leftRook->GetPosition().x > king->GetPosition().x)
-			swap(leftRook, rightRook);
-
-		if (leftRook != nullptr && !leftRook->HasMoved()) // long castle
-		{
-			Position pos = king->GetPosition();
-			pos.x--;
-
-			bool canCastle = true;
-			for (; canCastle; pos.x--)
-			{
-				if (GetPieceAt(pos) == leftRook)
-					break;
-
-				if (!IsEmpty(pos))
-				{
-					canCastle = false;
-					break;
-				}
-			}
-
-			if (canCastle)
-			{
-				auto r1 = TestMove(king->GetPosition(), Position(king->GetPosition().x - 2, king->GetPosition().y));
-				auto r2 = TestMove(leftRook->GetPosition(), Position(king->GetPosition().x + 1, king->GetPosition().y));
-
-				if (!IsCheck())
-					legalMoves[king].push_back(king->GetPosition());
-
-				ReverseTestMove(r2);
-				ReverseTestMove(r1);
-			}
-		}
-		if (rightRook != nullptr && !rightRook->HasMoved()) // short castle
-		{
-			Position pos = king->GetPosition();
-			pos.x++;
-
-			bool canCastle = true;
-			for (; canCastle; pos.x++)
-			{
-				if (GetPieceAt(pos) == rightRook)
-					break;
-
-				if (!IsEmpty(pos))
-				{
-					canCastle = false;
-					break;
-				}
-			}
-
-			if (canCastle)
-			{
-				auto r1 = TestMove(king->GetPosition(), Position(king->GetPosition().x + 2, king->GetPosition().y));
-				auto r2 = TestMove(rightRook->GetPosition(), Position(king->GetPosition().x - 1, king->GetPosition().y));
-
-				if (!IsCheck())
-					legalMoves[king].push_back(king->GetPosition());
-
-				ReverseTestMove(r2);
-				ReverseTestMove(r1);
-			}
-		}
 	}
 
-	void UpdateLegalMoves()
+	void UpdateLegalMoves() const
 	{
-		legalMoves.clear();
+		if (legalMovesUpToDate) return;
 
-		for (int i = 0; i < SIZE.y; i++)
-			for (int j = 0; j < SIZE.x; j++)
-				if (!IsEmpty({ j, i }) && GetTeam({ j, i }) == curTurn)
-				{
-					legalMoves[grid[i][j]] = {};
-
-					Piece* p = _GetPieceAt({ j, i });
-					auto moves = p->GetMoves(); // Must copy because of IsCheck
-					for (const auto& m : moves)
-					{
-						auto r = TestMove(p->GetPosition(), m);
+		legalMoves.Clear();
 
-						if (!IsCheck())
-							legalMoves[p].push_back(m);
+		RequireKing();
 
-						ReverseTestMove(r);
-					}
-				}
-
-		AddEnPassant();
-		AddCastles();
+		position.GenerateLegalMoves(legalMoves);
+		legalMovesUpToDate = true;
 	}
 
 
 	GameState CheckDraw() const
 	{
-		auto curHash = prevBoards.find(GetHash())->second;
-		if (curHash == 3)
+		if (position.RepetitionCount() >= 2)
 			return GameState(GameState::State::Draw, "by repetition");
 		else if (IsStalemate())
 			return GameState(GameState::State::Draw, "by stalemate");
-		else if (turnsWithoutCapture == 50)
+		else if (position.GetRule50() >= 100)
 			return GameState(GameState::State::Draw, "by 50-move rule");
 		return GameState();
 	}
 
+	// The state is only worked out once the clock has run out, so a game already over isn't lost on time
 	void CheckTimeout()
 	{
+		if (withoutTime || GetRemainingTime() > 0) return;
+
+		UpdateState();
 		if (state.state != GameState::State::Game) return;
 
-		if (!withoutTime && GetRemainingTime() <= 0)
-		{
-			state.state = (curTurn == PlayerTeam::White ? GameState::State::BlackWon : GameState::State::WhiteWon);
-			state.reason = "by timeout";
-		}
+		state.state = (GetTurn() == PlayerTeam::White ? GameState::State::BlackWon : GameState::State::WhiteWon);
+		state.reason = "by timeout";
 	}
-	void UpdateState()
+	void UpdateState() const
 	{
+		if (stateUpToDate) return;
+		stateUpToDate = true;
+
 		if (state.state != GameState::State::Game) return;
 
 		state = GameState();
 
 		if (IsMate())
 		{
-			state.state = (curTurn == PlayerTeam::White ? GameState::State::BlackWon : GameState::State::WhiteWon);
+			state.state = (GetTurn() == PlayerTeam::White ? GameState::State::BlackWon : GameState::State::WhiteWon);
 			state.reason = "by checkmate";
 		}
 		else state = CheckDraw();
@@ -330,9 +144,14 @@ class ChessBoard
 			}
 		}
 
-		prevBoards.clear();
+		position.Clear();
 		moves.clear();
+		notations.clear();
+		keyframes.clear();
+		history.clear();
 		state = GameState();
+		stateUpToDate = false;
+		legalMovesUpToDate = false;
 	}
 
 	Piece* _GetPieceAt(Position pos)
@@ -340,76 +159,15 @@ class ChessBoard
 		return grid[pos.y][pos.x];
 	}
 
-	string GetNotation(PieceMove move)
+	// Notation of moves[index] with its check mark, written from the position before it
+	string WriteNotation(int index) const
 	{
-		string res;
-		if (move.type == PieceMove::MoveType::CastleShort)
-			res = "O-O";
-		else if (move.type == PieceMove::MoveType::CastleLong)
-			res = "O-O-O";
-		else if (move.piece->GetType() == PieceType::Pawn)
-		{
-			res = ToNotation(move.to);
-			if (move.captured != nullptr)
-				res = FileToNotation(move.from) + 'x' + res;
-
-			if (move.type == PieceMove::MoveType::PromotionKnight)
-				res = res + "=N";
-			if (move.type == PieceMove::MoveType::PromotionBishop)
-				res = res + "=B";
-			if (move.type == PieceMove::MoveType::PromotionRook)
-				res = res + "=R";
-			if (move.type == PieceMove::MoveType::PromotionQueen)
-				res = res + "=Q";
-		}
-		else
-		{
-			switch (move.piece->GetType())
-			{
-			case PieceType::Knight: res += 'N'; break;
-			case PieceType::Bishop: res += 'B'; break;
-			case PieceType::Rook:   res += 'R'; break;
-			case PieceType::Queen:  res += 'Q'; break;
-			case PieceType::King:   res += 'K'; break;
-			}
-
-			bool ambiguity = false;
-			bool sameFiles = false;
-			bool sameRanks = false;
-
-			for (int i = 0; i < grid.size(); i++)
-				for (int j = 0; j < grid[i].size(); j++)
-					if (grid[i][j] != nullptr && grid[i][j] != move.piece && 
-						grid[i][j]->GetTeam() == move.piece->GetTeam() && 
-						grid[i][j]->GetType() == move.piece->GetType())
-					{
-						const auto& possibleMoves = GetLegalMoves(grid[i][j]);
-						if (find(possibleMoves.begin(), possibleMoves.end(), move.to) != possibleMoves.end())
-						{
-							ambiguity = true;
-							if (i == move.from.y)
-								sameRanks = true;
-							if (j == move.from.x)
-								sameFiles = true;
-						}
-					}
-			if (ambiguity)
-			{
-				if (sameFiles)
-				{
-					if (sameRanks)
-						res += ToNotation(move.from);
-					else
-						res += RankToNotation(move.from);
-				}
-				else
-					res += FileToNotation(move.from);
-			}
-			if (move.captured != nullptr)
-				res += 'x';
-			res += ToNotation(move.to);
-		}
+		ChessPosition before(GetSnapshotAt(index));
+		string res = before.ToSan(moves[index].packed);
 
+		before.DoMove(moves[index].packed);
+		if (before.IsCheck())
+			res += (before.HasLegalMove() ? '+' : '#');
 		return res;
 	}
 public:
@@ -417,28 +175,49 @@ public:
 
 	ChessBoard(Size size, TimeControl timeControl) :
 		SIZE(size), curMoveInd(-1),
-		grid(size.y, vector<Piece*>(size.x, nullptr)),
-		visibleByWhite(size.y, vector<bool>(size.x, false)),
-		visibleByBlack(size.y, vector<bool>(size.x, false)),
-		moves(), curTurn(PlayerTeam::White), realTurn(PlayerTeam::White),
+		grid(size.y, vector<Piece*>(size.x, nullptr)), position(),
+		moves(), notations(), realTurn(PlayerTeam::White),
+		state(), stateUpToDate(false), legalMovesUpToDate(false),
 		promoteToWhite(PieceType::Queen), promoteToBlack(PieceType::Queen),
 		withoutTime(false), timeControl(timeControl),
-		remainingTimeWhite(timeControl.time), remainingTimeBlack(timeControl.time),
-		turnsWithoutCapture(0)
-	{}
+		remainingTimeWhite(timeControl.time), remainingTimeBlack(timeControl.time)
+	{
+		assert(size == Size(8, 8)); // position is stored in 64-bit sets
+	}
 	
+	// pieces point back to their board and grid owns them, so a copy would free them twice, use GetSnapshot
+	ChessBoard(const ChessBoard&) = delete;
+	ChessBoard& operator= (const ChessBoard&) = delete;
+
 	~ChessBoard()
 	{
 		Clean();
 	}
 
+	// Starting position, castling is allowed wherever the king and the rook are on their squares
 	void InitGrid(vector<vector<Piece*> > grid)
+	{
+		InitGrid(grid, PlayerTeam::White, ALL_CASTLING, -1);
+	}
+	/*
+	* Position set up without its moves, e.g. loaded from FEN
+	* castlingRights are bits from ChessPosition.h, epSquare is -1 if there is none
+	*/
+	void InitGrid(vector<vector<Piece*> > grid, PlayerTeam turn, int castlingRights, int epSquare, int rule50 = 0)
 	{
 		Clean();
 		this->grid = grid;
-		prevBoards[GetHash()] = 1;
+
+		for (int i = 0; i < SIZE.y; i++)
+			for (int j = 0; j < SIZE.x; j++)
+				if (grid[i][j] != nullptr)
+					position.AddPiece(ToSquare({ j, i }), grid[i][j]->GetType(), grid[i][j]->GetTeam());
+
+		position.SetState(turn, castlingRights, epSquare, rule50);
+		realTurn = turn;
 
 		Update();
+		keyframes.push_back(position.GetSnapshot());
 	}
 
 	bool InBounds(Position pos) const
@@ -452,21 +231,31 @@ public:
 		return grid[pos.y][pos.x];
 	}
 
+	const ChessPosition& GetChessPosition() const
+	{
+		return position;
+	}
+	// Copy of the current position, safe to give to other threads and keep after the board is gone
+	BoardState GetSnapshot() const
+	{
+		return position.GetSnapshot();
+	}
+
 	bool IsEmpty(Position pos) const
 	{
-		return GetPieceAt(pos) == nullptr;
+		return position.IsEmpty(ToSquare(pos));
 	}
 	PlayerTeam GetTeam(Position pos) const
 	{
 		if (IsEmpty(pos))
 			throw "There is no piece";
-		return GetPieceAt(pos)->GetTeam();
+		return position.GetTeam(ToSquare(pos));
 	}
 	PieceType GetType(Position pos) const
 	{
 		if (IsEmpty(pos))
 			throw "There is no piece";
-		return GetPieceAt(pos)->GetType();
+		return position.GetType(ToSquare(pos));
 	}
 	bool HasMoved(Position pos) const
 	{
@@ -475,18 +264,18 @@ public:
 		return GetPieceAt(pos)->HasMoved();
 	}
 
+	// Called when the position changes, legal moves and state are only worked out when needed
 	void Update()
 	{
-		UpdatePieces();
-		UpdateLegalMoves();
-		UpdateState();
+		position.UpdateAttacks();
+		legalMovesUpToDate = false;
+		stateUpToDate = false;
 	}
 
-	void MoveBackward()
+private:
+	// Takes the current move back on the grid only, position is left to the caller
+	void StepBackward()
 	{
-		if (curMoveInd == -1)
-			return;
-
 		PieceMove move = moves[curMoveInd--];
 
 		Position from = move.from;
@@ -552,16 +341,10 @@ public:
 			grid[to.y][to.x] = captured;
 			grid[from.y][from.x] = p;
 		}
-
-		curTurn = OtherTeam(curTurn);
-
-		Update();
 	}
-	void MoveForward()
+	// Makes the next move of the record on the grid only, position is left to the caller
+	void StepForward()
 	{
-		if (curMoveInd + 1 == moves.size())
-			return;
-
 		PieceMove move = moves[++curMoveInd];
 
 		Position from = move.from;
@@ -617,19 +400,110 @@ public:
 			grid[to.y][to.x] = move.promoted;
 			grid[from.y][from.x] = nullptr;
 		}
+	}
+public:
+
+	void MoveBackward()
+	{
+		if (curMoveInd == -1)
+			return;
+
+		StepBackward();
+		position.UndoMove();
+		Update();
+	}
+	void MoveForward()
+	{
+		if (curMoveInd + 1 == moves.size())
+			return;
+
+		StepForward();
+		position.DoMove(moves[curMoveInd].packed);
+		Update();
+	}
+
+	int GetPly() const // plies of the record shown on the board
+	{
+		return curMoveInd + 1;
+	}
+	/*
+	* Shows the board after ply moves of the record, 0 is the starting position
+	* position is set from the nearest keyframe with at most KEYFRAME_INTERVAL - 1 moves replayed,
+	* its past moves come from history, so repetitions and stepping back still work
+	* The grid's pieces only know the squares they moved between, so it still swaps pointers ply by ply
+	*/
+	void GoToPly(int ply)
+	{
+		ply = max(0, min(ply, (int)moves.size()));
+		if (ply == GetPly())
+			return;
 
-		curTurn = OtherTeam(curTurn);
+		while (GetPly() > ply)
+			StepBackward();
+		while (GetPly() < ply)
+			StepForward();
 
+		int keyframe = min(ply / KEYFRAME_INTERVAL, (int)keyframes.size() - 1);
+		position.SetSnapshot(keyframes[keyframe], history.data(), keyframe * KEYFRAME_INTERVAL);
+		for (int i = keyframe * KEYFRAME_INTERVAL; i < ply; i++)
+			position.DoMove(moves[i].packed);
 		Update();
 	}
 
+	/*
+	* Position after ply moves of the record, without touching the board
+	* Starts from the nearest keyframe, so at most KEYFRAME_INTERVAL - 1 moves are replayed
+	*/
+	BoardState GetSnapshotAt(int ply) const
+	{
+		assert(ply >= 0 && ply <= (int)moves.size());
+
+		int keyframe = min(ply / KEYFRAME_INTERVAL, (int)keyframes.size() - 1);
+		ChessPosition res(keyframes[keyframe]);
+		for (int i = keyframe * KEYFRAME_INTERVAL; i < ply; i++)
+			res.DoMove(moves[i].packed);
+		return res.GetSnapshot();
+	}
+
 	PieceType promoteToWhite;	// what type white pawn promotes to
 	PieceType promoteToBlack;	// what type black pawn promotes to
 	void MovePiece(Position from, Position to)
+	{
+		RequireKing();
+
+		// only the moves of the piece on from, a game being loaded makes every move through here
+		MoveList candidates;
+		position.GenerateLegalMoves(candidates, MoveKind::All, SquareBB(from));
+
+		PieceType promoteTo = (GetTurn() == PlayerTeam::White ? promoteToWhite : promoteToBlack);
+		for (PackedMove m : candidates)
+			if (m.GetFrom() == ToSquare(from) && m.GetTo() == ToSquare(to) &&
+				(!m.IsPromotion() || m.GetPromotionType() == promoteTo))
+			{
+				MakeMove(m);
+				return;
+			}
+		throw "Illegal move";
+	}
+	// Throws if move isn't legal for the side to move, e.g. a move from another position
+	void MovePiece(PackedMove move)
+	{
+		RequireKing();
+		if (!position.IsLegal(move))
+			throw "Illegal move";
+
+		MakeMove(move);
+	}
+private:
+	// move must be legal, see MovePiece
+	void MakeMove(PackedMove move)
 	{
 		if (!withoutTime)
 			ChangeRemainingTime(timeControl.increment);
 
+		Position from = FromSquare(move.GetFrom());
+		Position to = FromSquare(move.GetTo());
+
 		Piece* p = _GetPieceAt(from);
 
 		if (curMoveInd + 1 < moves.size())
@@ -644,6 +518,7 @@ public:
 		moves.back().to = to;
 		moves.back().piece = p;
 		moves.back().type = PieceMove::MoveType::Move;
+		moves.back().packed = move;
 
 		p->Move(to);
 
@@ -652,21 +527,21 @@ public:
 		Piece* capture = nullptr;
 
 		// en passant
-		if (p->GetType() == PieceType::Pawn && from.x != to.x && IsEmpty(to))
+		if (move.IsEnPassant())
 		{
 			capture = grid[from.y][to.x];
 			grid[from.y][to.x] = nullptr;
 		}
 		else
 		// castles
-		if (p->GetType() == PieceType::King && abs(from.x - to.x) == 2)
+		if (move.IsCastle())
 		{
 			Piece* rook = nullptr;
 
 			int dir = (to.x - from.x) / 2; // direction of castling
 			
 			for (Position pos = p->GetPosition(); rook == nullptr; pos.x += dir)
-				if (!IsEmpty(pos) && GetTeam(pos) == curTurn && GetType(pos) == PieceType::Rook)
+				if (grid[pos.y][pos.x] != nullptr && grid[pos.y][pos.x]->GetType() == PieceType::Rook)
 					rook = grid[pos.y][pos.x];
 
 			grid[rook->GetPosition().y][rook->GetPosition().x] = nullptr;
@@ -677,7 +552,7 @@ public:
 		}
 		else
 		// capture
-		if (!IsEmpty(to))
+		if (grid[to.y][to.x] != nullptr)
 		{
 			capture = grid[to.y][to.x];
 			grid[to.y][to.x] = nullptr;
@@ -686,12 +561,13 @@ public:
 		moves.back().captured = capture;
 
 		// promotion
-		if (p->GetType() == PieceType::Pawn && (to.y == 0 || to.y == 7))
+		if (move.IsPromotion())
 		{
-			PieceType promoteTo = (curTurn == PlayerTeam::White ? promoteToWhite : promoteToBlack);
+			PieceType promoteTo = move.GetPromotionType();
 
 			p->SetPosition(from);
-			grid[to.y][to.x] = moves.back().promoted = MakePiece(promoteTo, to, p->GetTeam(), this);
+			moves.back().promoted = MakePiece(promoteTo, to, p->GetTeam(), this);
+			grid[to.y][to.x] = moves.back().promoted;
 
 			switch (promoteTo)
 			{
@@ -701,64 +577,45 @@ public:
 			case PieceType::Queen:  moves.back().type = PieceMove::MoveType::PromotionQueen;  break;
 			}
 		}
-		moves.back().notation = GetNotation(moves.back());
-
-		curTurn = (curTurn == PlayerTeam::White ? PlayerTeam::Black : PlayerTeam::White);
-		realTurn = curTurn;
-		UpdatePieces();
+		notations.push_back(-1);
 
-		UpdateLegalMoves();
+		position.DoMove(move);
+		realTurn = GetTurn();
+		legalMovesUpToDate = false;
+		stateUpToDate = false;
 
-		moves.back().check = IsCheck();
-		if (moves.back().check)
-			moves.back().mate = IsMate();
-
-		if (moves.back().mate)
-			moves.back().notation += '#';
-		else if (moves.back().check)
-			moves.back().notation += '+';
-
-		turnsWithoutCapture++;
-		if (capture != nullptr || p->GetType() == PieceType::Pawn)
-			turnsWithoutCapture = 0;
-
-		prevBoards[GetHash()]++;
-
-		UpdateState();
+		history.push_back(position.GetHistory().back());
+		if (moves.size() % KEYFRAME_INTERVAL == 0)
+			keyframes.push_back(position.GetSnapshot());
 	}
+public:
 
 	bool IsCheck() const
 	{
-		Piece* king = nullptr;
-		for (int i = 0; i < SIZE.y && king == nullptr; i++)
-			for (int j = 0; j < SIZE.x && king == nullptr; j++)
-				if (!IsEmpty({ j, i }) && GetTeam({ j, i }) == curTurn && GetType({j, i}) == PieceType::King)
-					king = grid[i][j];
-
-		if (king == nullptr)
-			throw "King not found";
-
-		return GetVisibleBy(OtherTeam(curTurn), king->GetPosition());
+		RequireKing();
+		return position.IsCheck();
+	}
+	// Moves already generated are reused, otherwise the search stops at the first legal move
+	bool HasLegalMove() const
+	{
+		if (legalMovesUpToDate)
+			return !legalMoves.IsEmpty();
+		RequireKing();
+		return position.HasLegalMove();
 	}
 	bool IsMate() const
 	{
 		if (!IsCheck())
 			return false;
 
-		for (auto& p : legalMoves)
-			if (!p.second.empty())
-				return false;
-		return true;
+		return !HasLegalMove();
 	}
 	bool IsStalemate() const
 	{
 		if (IsCheck())
 			return false;
 
-		for (auto& p : legalMoves)
-			if (!p.second.empty())
-				return false;
-		return true;
+		return !HasLegalMove();
 	}
 
 	bool IsLastMove() const
@@ -767,7 +624,7 @@ public:
 	}
 	void ToLastMove()
 	{
-		while (!IsLastMove()) MoveForward();
+		GoToPly((int)moves.size());
 	}
 
 	bool WithoutTime() const
@@ -775,54 +632,93 @@ public:
 		return withoutTime;
 	}
 
-	const map<Piece*, vector<Position> >& GetLegalMoves() const
+	const MoveList& GetLegalMoves() const
 	{
+		UpdateLegalMoves();
 		return legalMoves;
 	}
-	const vector<Position>& GetLegalMoves(Piece* p) const
-	{
-		return legalMoves.at(p);
-	}
-	const vector<Position>& GetLegalMoves(const Piece* p) const
+	vector<Position> GetLegalMoves(const Piece* p) const // destination squares of the piece
 	{
-		return legalMoves.at((Piece*)p);
+		vector<Position> res;
+		int from = ToSquare(p->GetPosition());
+		for (PackedMove m : GetLegalMoves())
+			if (m.GetFrom() == from && (!m.IsPromotion() || m.GetPromotionType() == PieceType::Queen))
+				res.push_back(FromSquare(m.GetTo()));
+		return res;
 	}
 
 	PlayerTeam GetTurn() const
 	{
-		return curTurn;
+		return position.GetTurn();
 	}
 
-	const vector<vector<bool> >& GetVisibleBy(PlayerTeam team) const
+	Bitboard GetVisibleBy(PlayerTeam team) const
 	{
-		return (team == PlayerTeam::White ? visibleByWhite : visibleByBlack);
+		return position.GetAttacked(team);
 	}
-	const vector<vector<bool> >& GetVisibleByWhite() const
+	Bitboard GetVisibleByWhite() const
 	{
-		return visibleByWhite;
+		return position.GetAttacked(PlayerTeam::White);
 	}
-	const vector<vector<bool> >& GetVisibleByBlack() const
+	Bitboard GetVisibleByBlack() const
 	{
-		return visibleByBlack;
+		return position.GetAttacked(PlayerTeam::Black);
 	}
 
 	bool GetVisibleBy(PlayerTeam team, Position pos) const
 	{
-		return (team == PlayerTeam::White ? visibleByWhite : visibleByBlack)[pos.y][pos.x];
+		return HasSquare(position.GetAttacked(team), pos);
 	}
 	bool GetVisibleByWhite(Position pos) const
 	{
-		return visibleByWhite[pos.y][pos.x];
+		return HasSquare(position.GetAttacked(PlayerTeam::White), pos);
 	}
 	bool GetVisibleByBlack(Position pos) const
 	{
-		return visibleByBlack[pos.y][pos.x];
+		return HasSquare(position.GetAttacked(PlayerTeam::Black), pos);
+	}
+
+	// Squares of the pieces of team attacking pos, PopCount gives how many
+	Bitboard GetAttackersOf(Position pos, PlayerTeam team) const
+	{
+		return position.AttackersTo(ToSquare(pos), position.GetOccupied()) & position.GetPieces(team);
+	}
+	// Whether the enemy wins material by taking the piece on pos with its cheapest attacker, see SEE
+	bool IsHanging(Position pos) const
+	{
+		if (IsEmpty(pos))
+			return false;
+
+		PlayerTeam enemy = OtherTeam(GetTeam(pos));
+		Bitboard attackers = GetAttackersOf(pos, enemy);
+		for (int t = (int)PieceType::Pawn; t <= (int)PieceType::King; t++)
+		{
+			Bitboard bb = attackers & position.GetPieces(enemy, PieceType(t));
+			if (!bb)
+				continue;
+			// the king can only take a piece nobody defends
+			if (t == (int)PieceType::King)
+				return GetAttackersOf(pos, OtherTeam(enemy)) == EMPTY_BB;
+			return SEE(position, PackedMove(LowestSquare(bb), ToSquare(pos))) > 0;
+		}
+		return false;
 	}
 
 	const vector<PieceMove>& GetMovesRecord() const
 	{
 		return moves;
 	}
+	/*
+	* Standard algebraic notation of moves[index], e.g. "Nbd7" or "exd8=Q#"
+	* Written the first time it is asked for, so making or loading moves never spends time on it
+	*/
+	const string& GetNotation(int index) const
+	{
+		if (notations[index] == -1)
+			notations[index] = NotationTable::Get().Add(WriteNotation(index));
+		return NotationTable::Get().GetString(notations[index]);
+	}
+
 	const PieceMove GetLastMove() const
 	{
 		if (moves.empty())
@@ -832,6 +728,7 @@ public:
 
 	GameState GetGameState() const
 	{
+		UpdateState();
 		return state;
 	}
 
@@ -878,24 +775,12 @@ public:
 	}
 
 	/*
-	* Returns string with size of 32, unique for every board
-	* First 4 bits of i sumbol is grid[i / 8][i % 8], second 4 is grid[i / 8][i % 8 + 1]
+	* Returns Zobrist key of the position on the board
+	* Covers pieces, turn, castling rights and en passant, updated incrementally by every move
 	*/
-	string GetHash() const
+	uint64_t GetHash() const
 	{
-		string hash;
-		for (int i = 0; i < 64; i += 2)
-		{
-			int x = i / 8, y = i % 8;
-			unsigned char c = 0;
-			if (grid[x][y + 1] != nullptr)
-				c |= ((int)grid[x][y + 1]->GetType() + 1) | (8 * (grid[x][y + 1]->GetTeam() == PlayerTeam::Black));
-			c <<= 4;
-			if (grid[x][y] != nullptr)
-				c |= ((int)grid[x][y]->GetType() + 1) | (8 * (grid[x][y]->GetTeam() == PlayerTeam::Black));
-			hash += c;
-		}
-		return hash;
+		return position.GetKey();
 	}
 
 	friend class Game;
@@ -0,0 +1,932 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <sstream>
+#include <algorithm>
+#include <type_traits>
+
+#include "Coords.h"
+#include "Other.h"
+#include "Bitboard.h"
+#include "Attacks.h"
+#include "PackedMove.h"
+#include "Zobrist.h"
+
+
+// castling rights bits
+const int WHITE_SHORT_CASTLE = 1;
+const int WHITE_LONG_CASTLE = 2;
+const int BLACK_SHORT_CASTLE = 4;
+const int BLACK_LONG_CASTLE = 8;
+const int ALL_CASTLING = WHITE_SHORT_CASTLE | WHITE_LONG_CASTLE | BLACK_SHORT_CASTLE | BLACK_LONG_CASTLE;
+
+int ShortCastleRight(PlayerTeam team)
+{
+	return (team == PlayerTeam::White ? WHITE_SHORT_CASTLE : BLACK_SHORT_CASTLE);
+}
+int LongCastleRight(PlayerTeam team)
+{
+	return (team == PlayerTeam::White ? WHITE_LONG_CASTLE : BLACK_LONG_CASTLE);
+}
+
+// rights kept by a move from or to a square, anything touching a king or rook square loses its rights
+const int CASTLING_MASK[64] = {
+	13, 15, 15, 15, 12, 15, 15, 14,
+	15, 15, 15, 15, 15, 15, 15, 15,
+	15, 15, 15, 15, 15, 15, 15, 15,
+	15, 15, 15, 15, 15, 15, 15, 15,
+	15, 15, 15, 15, 15, 15, 15, 15,
+	15, 15, 15, 15, 15, 15, 15, 15,
+	15, 15, 15, 15, 15, 15, 15, 15,
+	 7, 15, 15, 15,  3, 15, 15, 11
+};
+
+const string PIECE_LETTERS = "PNBRQK"; // by PieceType
+
+// [team][short, long]
+const Bitboard CASTLING_PATH[2][2] = {		// between the king and the rook, must be empty
+	{ 0x60ULL, 0x0EULL },
+	{ 0x60ULL << 56, 0x0EULL << 56 }
+};
+const Bitboard CASTLING_SAFE[2][2] = {		// passed by the king, must not be attacked
+	{ 0x60ULL, 0x0CULL },
+	{ 0x60ULL << 56, 0x0CULL << 56 }
+};
+
+
+/*
+* Contents of a square in one byte: type in the low 3 bits, team in bit 3
+*/
+typedef uint8_t PieceCode;
+const PieceCode NO_PIECE = (PieceCode)PieceType::Count; // its type is PieceType::Count
+
+PieceCode MakePieceCode(PieceType type, PlayerTeam team)
+{
+	return (PieceCode)((int)type | ((int)team << 3));
+}
+PieceType CodeType(PieceCode code)
+{
+	return PieceType(code & 7);
+}
+PlayerTeam CodeTeam(PieceCode code) // code must not be NO_PIECE
+{
+	return PlayerTeam(code >> 3);
+}
+
+
+// Parts of the legal moves, see ChessPosition::GenerateLegalMoves
+enum class MoveKind
+{
+	All,
+	Captures,	// with en passant and every promotion
+	Quiets		// the rest, with castling
+};
+
+
+/*
+* Everything that makes up a position, plain data without pointers
+* Cheap to copy, so snapshots can be handed to other threads without touching the game
+* The move history isn't part of it, see ChessPosition
+*/
+struct BoardState
+{
+	Bitboard pieces[2][(int)PieceType::Count];
+	Bitboard teams[2];
+	Bitboard occupied;
+	PieceCode squares[64];		// the same pieces by square, so a square is read without searching the sets
+
+	Bitboard attacksFrom[64];	// squares attacked by the piece on a square
+	Bitboard attacked[2];		// squares attacked by a team
+	Bitboard changed;			// squares added or removed since the last UpdateAttacks
+
+	int kingSquare[2];			// -1 if the team has no king
+	Bitboard checkers;			// enemy pieces attacking the king of the side to move
+
+	PlayerTeam turn;
+	int castlingRights;
+	int epSquare;				// square passed by a pawn double push on the last move, -1 if there is none
+	int rule50;					// plies since the last capture or pawn move
+
+	uint64_t key;
+};
+static_assert(is_trivially_copyable_v<BoardState>, "BoardState must stay plain data");
+
+
+/*
+* Bitboard representation of the pieces on the board
+* One set of squares for every piece type of every team, plus occupancy sets
+* Attack maps are kept up to date incrementally, see UpdateAttacks
+* So is the Zobrist key, it covers the pieces, turn, castling rights and en passant square
+* The position itself is a BoardState, the undo stack holds the moves made since it was set
+*/
+class ChessPosition : BoardState
+{
+public:
+	// what DoMove can't recompute when the move is taken back
+	struct UndoInfo
+	{
+		PackedMove move;
+		PieceType captured;		// PieceType::Count if nothing was captured
+		int castlingRights;
+		int epSquare;
+		int rule50;
+		uint64_t key;			// key before the move, also the history for repetitions
+	};
+private:
+	vector<UndoInfo> undoStack;
+public:
+	static const int MAX_PLY = 1024; // undo records reserved up front by a long-lived position
+
+	// Empty board, for a position that lives long, e.g. a game's or a search's, see SetSnapshot
+	ChessPosition() : undoStack()
+	{
+		InitAttacks();
+		InitZobrist();
+		undoStack.reserve(MAX_PLY);
+		Clear();
+	}
+	/*
+	* Position from a snapshot, without the moves that led to it (so no repetitions before it)
+	* Meant for short-lived copies that make a few moves, so the undo stack grows only as moves are made
+	*/
+	explicit ChessPosition(const BoardState& snapshot) : BoardState(snapshot), undoStack()
+	{
+		InitAttacks();
+		InitZobrist();
+	}
+
+	const BoardState& GetSnapshot() const
+	{
+		return *this;
+	}
+	void SetSnapshot(const BoardState& snapshot)
+	{
+		(BoardState&)*this = snapshot;
+		undoStack.clear();
+	}
+	/*
+	* Snapshot reached by the first plies moves of history, as GetHistory returned them
+	* Those moves can then be taken back and count for repetitions, as if they were made here
+	*/
+	void SetSnapshot(const BoardState& snapshot, const UndoInfo* history, int plies)
+	{
+		(BoardState&)*this = snapshot;
+		undoStack.assign(history, history + plies);
+	}
+	// Undo records of the moves made since the snapshot, oldest first
+	const vector<UndoInfo>& GetHistory() const
+	{
+		return undoStack;
+	}
+
+	void Clear()
+	{
+		for (int t = 0; t < 2; t++)
+		{
+			for (int i = 0; i < (int)PieceType::Count; i++)
+				pieces[t][i] = EMPTY_BB;
+			teams[t] = EMPTY_BB;
+			attacked[t] = EMPTY_BB;
+			kingSquare[t] = -1;
+		}
+		occupied = EMPTY_BB;
+
+		for (int sq = 0; sq < 64; sq++)
+		{
+			squares[sq] = NO_PIECE;
+			attacksFrom[sq] = EMPTY_BB;
+		}
+		changed = EMPTY_BB;
+		checkers = EMPTY_BB;
+
+		turn = PlayerTeam::White;
+		castlingRights = 0;
+		epSquare = -1;
+		rule50 = 0;
+		key = ZobristCastling(0);
+		undoStack.clear();
+	}
+
+	void SetTurn(PlayerTeam team)
+	{
+		if (team != turn)
+			key ^= ZOBRIST_BLACK_TURN;
+		turn = team;
+	}
+	void SetCastlingRights(int rights)
+	{
+		key ^= ZobristCastling(castlingRights) ^ ZobristCastling(rights);
+		castlingRights = rights;
+	}
+	void SetEpSquare(int square)
+	{
+		key ^= ZobristEp(epSquare) ^ ZobristEp(square);
+		epSquare = square;
+	}
+	void SetRule50(int plies)
+	{
+		rule50 = plies;
+	}
+
+	/*
+	* Sets what can't be seen from the pieces, for positions set up without their moves
+	* Castling rights without the king and the rook on their squares are dropped,
+	* and so is an en passant square no pawn can take (DoMove doesn't set those either)
+	*/
+	void SetState(PlayerTeam turn, int castlingRights, int epSquare, int rule50)
+	{
+		for (PlayerTeam team : { PlayerTeam::White, PlayerTeam::Black })
+		{
+			int base = (team == PlayerTeam::White ? 0 : 56);
+			Bitboard rooks = pieces[(int)team][(int)PieceType::Rook];
+			if (kingSquare[(int)team] != base + 4)
+				castlingRights &= ~(ShortCastleRight(team) | LongCastleRight(team));
+			if (!HasSquare(rooks, base + 7))
+				castlingRights &= ~ShortCastleRight(team);
+			if (!HasSquare(rooks, base))
+				castlingRights &= ~LongCastleRight(team);
+		}
+
+		if (epSquare != -1 && !(PawnAttacks(OtherTeam(turn), epSquare) & pieces[(int)turn][(int)PieceType::Pawn]))
+			epSquare = -1;
+
+		SetTurn(turn);
+		SetCastlingRights(castlingRights);
+		SetEpSquare(epSquare);
+		SetRule50(rule50);
+	}
+
+	/*
+	* Replaces the position with the one in Forsyth-Edwards Notation
+	* Move counters may be omitted, throws if the rest is malformed,
+	* the placement doesn't cover 8x8 squares, a side hasn't exactly one king, a pawn is on rank 1 or 8
+	* or the side that just moved is left in check
+	*/
+	void LoadFen(const string& fen)
+	{
+		istringstream in(fen);
+		string placement, side, castling = "-", ep = "-";
+		int halfmoves = 0;
+		in >> placement >> side >> castling >> ep >> halfmoves;
+		if (side != "w" && side != "b")
+			throw "Invalid FEN";
+
+		Clear();
+
+		const string symbols = "pnbrqk";
+		int x = 0, y = 7;
+		for (char c : placement)
+		{
+			if (c == '/')
+			{
+				if (x != 8)
+					throw "Invalid FEN";
+				x = 0, y--;
+				continue;
+			}
+			if (c >= '1' && c <= '8')
+			{
+				x += c - '0';
+				if (x > 8)
+					throw "Invalid FEN";
+				continue;
+			}
+
+			size_t type = symbols.find((char)tolower(c));
+			if (type == string::npos || x > 7 || y < 0)
+				throw "Invalid FEN";
+			AddPiece(y * 8 + x, PieceType(type), (isupper(c) ? PlayerTeam::White : PlayerTeam::Black));
+			x++;
+		}
+		if (x != 8 || y != 0)
+			throw "Invalid FEN";
+
+		// the move generator needs both kings, and a pawn on the first or last rank couldn't move
+		for (int t = 0; t < 2; t++)
+			if (PopCount(pieces[t][(int)PieceType::King]) != 1)
+				throw "Invalid FEN";
+		if (GetPieces(PieceType::Pawn) & (RankBB(0) | RankBB(56)))
+			throw "Invalid FEN";
+		// otherwise its king could be taken, and the generator would go on without it
+		const PlayerTeam toMove = (side == "w" ? PlayerTeam::White : PlayerTeam::Black);
+		if (IsAttacked(kingSquare[(int)OtherTeam(toMove)], toMove, occupied))
+			throw "Invalid FEN";
+
+		int rights = 0;
+		for (char c : castling)
+			switch (c)
+			{
+			case 'K': rights |= WHITE_SHORT_CASTLE; break;
+			case 'Q': rights |= WHITE_LONG_CASTLE; break;
+			case 'k': rights |= BLACK_SHORT_CASTLE; break;
+			case 'q': rights |= BLACK_LONG_CASTLE; break;
+			}
+
+		int epSquare = -1;
+		if (ep.size() == 2 && ep[0] >= 'a' && ep[0] <= 'h' && ep[1] >= '1' && ep[1] <= '8')
+			epSquare = (ep[1] - '1') * 8 + (ep[0] - 'a');
+
+		SetState(toMove, rights, epSquare, halfmoves);
+		UpdateAttacks();
+	}
+
+	PlayerTeam GetTurn() const
+	{
+		return turn;
+	}
+	int GetCastlingRights() const
+	{
+		return castlingRights;
+	}
+	int GetEpSquare() const
+	{
+		return epSquare;
+	}
+	int GetRule50() const
+	{
+		return rule50;
+	}
+	uint64_t GetKey() const
+	{
+		return key;
+	}
+	int GetPly() const // moves made with DoMove that can be taken back
+	{
+		return (int)undoStack.size();
+	}
+
+	void AddPiece(int square, PieceType type, PlayerTeam team)
+	{
+		Bitboard bb = SquareBB(square);
+		pieces[(int)team][(int)type] |= bb;
+		teams[(int)team] |= bb;
+		occupied |= bb;
+		changed |= bb;
+		squares[square] = MakePieceCode(type, team);
+		key ^= ZobristPiece(team, type, square);
+
+		if (type == PieceType::King)
+			kingSquare[(int)team] = square;
+	}
+	void RemovePiece(int square, PieceType type, PlayerTeam team)
+	{
+		Bitboard bb = ~SquareBB(square);
+		pieces[(int)team][(int)type] &= bb;
+		teams[(int)team] &= bb;
+		occupied &= bb;
+		changed |= ~bb;
+		squares[square] = NO_PIECE;
+		key ^= ZobristPiece(team, type, square);
+
+		if (type == PieceType::King && kingSquare[(int)team] == square)
+			kingSquare[(int)team] = -1;
+	}
+
+	/*
+	* Brings attack maps and checkers up to date after pieces were added or removed or the turn was set
+	* Only the pieces on changed squares and the sliders whose rays reach them are recomputed
+	*/
+	void UpdateAttacks()
+	{
+		UpdateAttackMaps();
+
+		int king = kingSquare[(int)turn];
+		checkers = (king == -1 ? EMPTY_BB : AttackersTo(king, occupied) & teams[(int)OtherTeam(turn)]);
+	}
+private:
+	void UpdateAttackMaps()
+	{
+		if (changed == EMPTY_BB) return;
+
+		Bitboard sliders = GetPieces(PieceType::Bishop) | GetPieces(PieceType::Rook) | GetPieces(PieceType::Queen);
+
+		Bitboard update = changed & occupied;
+		for (Bitboard bb = sliders & ~update; bb;)
+		{
+			int sq = PopLowestSquare(bb);
+			if (attacksFrom[sq] & changed)
+				update |= SquareBB(sq);
+		}
+
+		for (Bitboard bb = changed & ~occupied; bb;)
+			attacksFrom[PopLowestSquare(bb)] = EMPTY_BB;
+		for (Bitboard bb = update; bb;)
+		{
+			int sq = PopLowestSquare(bb);
+			attacksFrom[sq] = PieceAttacks(GetType(sq), GetTeam(sq), sq, occupied);
+		}
+		changed = EMPTY_BB;
+
+		for (int t = 0; t < 2; t++)
+		{
+			attacked[t] = EMPTY_BB;
+			for (Bitboard bb = teams[t]; bb;)
+				attacked[t] |= attacksFrom[PopLowestSquare(bb)];
+		}
+	}
+public:
+
+
+	Bitboard GetPieces(PlayerTeam team, PieceType type) const
+	{
+		return pieces[(int)team][(int)type];
+	}
+	Bitboard GetPieces(PieceType type) const
+	{
+		return pieces[0][(int)type] | pieces[1][(int)type];
+	}
+	Bitboard GetPieces(PlayerTeam team) const
+	{
+		return teams[(int)team];
+	}
+	Bitboard GetOccupied() const
+	{
+		return occupied;
+	}
+
+	Bitboard GetAttacked(PlayerTeam team) const
+	{
+		return attacked[(int)team];
+	}
+	Bitboard GetAttacksFrom(int square) const
+	{
+		return attacksFrom[square];
+	}
+
+	int GetKingSquare(PlayerTeam team) const
+	{
+		return kingSquare[(int)team];
+	}
+	Bitboard GetCheckers() const
+	{
+		return checkers;
+	}
+	bool IsCheck() const
+	{
+		return checkers != EMPTY_BB;
+	}
+
+	bool IsEmpty(int square) const
+	{
+		return !HasSquare(occupied, square);
+	}
+	PlayerTeam GetTeam(int square) const // square must not be empty
+	{
+		return CodeTeam(squares[square]);
+	}
+	PieceType GetType(int square) const // PieceType::Count if the square is empty
+	{
+		return CodeType(squares[square]);
+	}
+	PieceCode GetPieceCode(int square) const
+	{
+		return squares[square];
+	}
+
+
+	// Pieces of both teams attacking square, occupied is used to block sliders
+	Bitboard AttackersTo(int square, Bitboard occupied) const
+	{
+		return (PawnAttacks(PlayerTeam::White, square) & pieces[(int)PlayerTeam::Black][(int)PieceType::Pawn]) |
+			(PawnAttacks(PlayerTeam::Black, square) & pieces[(int)PlayerTeam::White][(int)PieceType::Pawn]) |
+			(KnightAttacks(square) & GetPieces(PieceType::Knight)) |
+			(KingAttacks(square) & GetPieces(PieceType::King)) |
+			(BishopAttacks(square, occupied) & (GetPieces(PieceType::Bishop) | GetPieces(PieceType::Queen))) |
+			(RookAttacks(square, occupied) & (GetPieces(PieceType::Rook) | GetPieces(PieceType::Queen)));
+	}
+	bool IsAttacked(int square, PlayerTeam by, Bitboard occupied) const
+	{
+		return (AttackersTo(square, occupied) & teams[(int)by]) != EMPTY_BB;
+	}
+
+	// Pieces of team that can't leave the line between their king and an enemy slider
+	Bitboard GetPinned(PlayerTeam team) const
+	{
+		PlayerTeam enemy = OtherTeam(team);
+		int king = kingSquare[(int)team];
+
+		Bitboard snipers =
+			(BishopAttacks(king, EMPTY_BB) & (pieces[(int)enemy][(int)PieceType::Bishop] | pieces[(int)enemy][(int)PieceType::Queen])) |
+			(RookAttacks(king, EMPTY_BB) & (pieces[(int)enemy][(int)PieceType::Rook] | pieces[(int)enemy][(int)PieceType::Queen]));
+
+		Bitboard pinned = EMPTY_BB;
+		while (snipers)
+		{
+			Bitboard blockers = BETWEEN[king][PopLowestSquare(snipers)] & occupied;
+			if (PopCount(blockers) == 1)
+				pinned |= blockers & teams[(int)team];
+		}
+		return pinned;
+	}
+
+	/*
+	* Appends every legal move of the side to move to moves
+	* Pins, checkers and the evasion mask are computed once, so no move has to be tried on the board
+	* kind picks a part of them, so a search can make the captures before the rest are generated
+	* fromMask keeps only the moves of the pieces on it, e.g. of the one piece a user picked up
+	*/
+	void GenerateLegalMoves(MoveList& moves, MoveKind kind = MoveKind::All, Bitboard fromMask = FULL_BB) const
+	{
+		GenerateMoves([&](PackedMove move) { moves.Push(move); return false; }, kind, fromMask);
+	}
+	// Whether move is a legal move of the side to move, e.g. a move remembered from another position
+	bool IsLegal(PackedMove move) const
+	{
+		if (move.IsNone() || IsEmpty(move.GetFrom()) || GetTeam(move.GetFrom()) != turn)
+			return false;
+
+		return GenerateMoves([&](PackedMove m) { return m == move; }, MoveKind::All, SquareBB(move.GetFrom()));
+	}
+private:
+	/*
+	* Legal moves of kind made by the pieces on fromMask, each handed to push
+	* push returns true to stop, then so does GenerateMoves, so a caller can stop at the first move it needs
+	*/
+	template <typename Sink>
+	bool GenerateMoves(Sink push, MoveKind kind, Bitboard fromMask) const
+	{
+		const PlayerTeam team = turn;
+		const PlayerTeam enemy = OtherTeam(team);
+		const Bitboard own = teams[(int)team];
+		const Bitboard enemies = teams[(int)enemy];
+		const int king = kingSquare[(int)team];
+
+		// destinations of the kind, pawns are sorted out on their own since promotions count as captures
+		const Bitboard kindMask = (kind == MoveKind::Captures ? enemies : kind == MoveKind::Quiets ? ~occupied : FULL_BB);
+
+		// in check the king is taken off the board, so it can't step back along the ray of a checking slider
+		const Bitboard withoutKing = occupied ^ SquareBB(king);
+		for (Bitboard targets = (HasSquare(fromMask, king) ? KingAttacks(king) & ~own & ~attacked[(int)enemy] & kindMask : EMPTY_BB); targets;)
+		{
+			int to = PopLowestSquare(targets);
+			if (!checkers || !IsAttacked(to, enemy, withoutKing))
+				if (push(PackedMove(king, to)))
+					return true;
+		}
+
+		if (PopCount(checkers) > 1) // only the king can escape a double check
+			return false;
+
+		// squares that capture the checker or block its ray
+		const Bitboard evasionMask = (checkers ? BETWEEN[king][LowestSquare(checkers)] | checkers : FULL_BB);
+		const Bitboard pinned = GetPinned(team);
+
+		auto pushAll = [&](int from, Bitboard targets)
+		{
+			targets &= evasionMask & kindMask;
+			if (HasSquare(pinned, from))
+				targets &= LINE[king][from];
+			while (targets)
+				if (push(PackedMove(from, PopLowestSquare(targets))))
+					return true;
+			return false;
+		};
+
+		for (Bitboard bb = pieces[(int)team][(int)PieceType::Knight] & ~pinned & fromMask; bb;)
+		{
+			int from = PopLowestSquare(bb);
+			if (pushAll(from, KnightAttacks(from) & ~own))
+				return true;
+		}
+		for (Bitboard bb = (pieces[(int)team][(int)PieceType::Bishop] | pieces[(int)team][(int)PieceType::Queen]) & fromMask; bb;)
+		{
+			int from = PopLowestSquare(bb);
+			if (pushAll(from, BishopAttacks(from, occupied) & ~own))
+				return true;
+		}
+		for (Bitboard bb = (pieces[(int)team][(int)PieceType::Rook] | pieces[(int)team][(int)PieceType::Queen]) & fromMask; bb;)
+		{
+			int from = PopLowestSquare(bb);
+			if (pushAll(from, RookAttacks(from, occupied) & ~own))
+				return true;
+		}
+
+		const int forward = (team == PlayerTeam::White ? 8 : -8);
+		const int startRank = (team == PlayerTeam::White ? 1 : 6);
+		const int lastRank = (team == PlayerTeam::White ? 7 : 0);
+		const Bitboard lastRankBB = RankBB(lastRank * 8);
+		for (Bitboard bb = pieces[(int)team][(int)PieceType::Pawn] & fromMask; bb;)
+		{
+			int from = PopLowestSquare(bb);
+
+			Bitboard targets = PawnAttacks(team, from) & enemies;
+			if (IsEmpty(from + forward))
+			{
+				targets |= SquareBB(from + forward);
+				if (from / 8 == startRank && IsEmpty(from + 2 * forward))
+					targets |= SquareBB(from + 2 * forward);
+			}
+
+			if (kind == MoveKind::Captures)
+				targets &= enemies | lastRankBB;
+			else if (kind == MoveKind::Quiets)
+				targets &= ~enemies & ~lastRankBB;
+
+			targets &= evasionMask;
+			if (HasSquare(pinned, from))
+				targets &= LINE[king][from];
+			while (targets)
+			{
+				int to = PopLowestSquare(targets);
+				if (to / 8 == lastRank)
+				{
+					for (int t = (int)PieceType::Knight; t <= (int)PieceType::Queen; t++)
+						if (push(PackedMove(from, to, PromotionFlag(PieceType(t)))))
+							return true;
+				}
+				else if (push(PackedMove(from, to, (to == from + 2 * forward ? PackedMove::Flag::DoublePush : PackedMove::Flag::Quiet))))
+					return true;
+			}
+		}
+
+		if (epSquare != -1 && kind != MoveKind::Quiets)
+		{
+			const int captured = epSquare - forward;
+			for (Bitboard bb = PawnAttacks(enemy, epSquare) & pieces[(int)team][(int)PieceType::Pawn] & fromMask; bb;)
+			{
+				int from = PopLowestSquare(bb);
+
+				// two pawns leave the rank at once, so the resulting position is checked directly
+				Bitboard after = (occupied ^ SquareBB(from) ^ SquareBB(captured)) | SquareBB(epSquare);
+				if (!(AttackersTo(king, after) & enemies & ~SquareBB(captured)) &&
+					push(PackedMove(from, epSquare, PackedMove::Flag::EnPassant)))
+					return true;
+			}
+		}
+
+		// a right means the king and the rook are still on their squares
+		if (!checkers && kind != MoveKind::Captures && HasSquare(fromMask, king))
+		{
+			if ((castlingRights & ShortCastleRight(team)) &&
+				!(occupied & CASTLING_PATH[(int)team][0]) && !(attacked[(int)enemy] & CASTLING_SAFE[(int)team][0]) &&
+				push(PackedMove(king, king + 2, PackedMove::Flag::CastleShort)))
+				return true;
+
+			if ((castlingRights & LongCastleRight(team)) &&
+				!(occupied & CASTLING_PATH[(int)team][1]) && !(attacked[(int)enemy] & CASTLING_SAFE[(int)team][1]) &&
+				push(PackedMove(king, king - 2, PackedMove::Flag::CastleLong)))
+				return true;
+		}
+		return false;
+	}
+public:
+
+	// Whether the side to move has any legal move, the generator stops at the first one
+	bool HasLegalMove() const
+	{
+		return GenerateMoves([](PackedMove) { return true; }, MoveKind::All, FULL_BB);
+	}
+
+	/*
+	* Standard algebraic notation of a legal move, without the check and mate marks
+	* Other pieces that could go to the same square come from one attack lookup, pinned ones are left out
+	*/
+	string ToSan(PackedMove move) const
+	{
+		if (move.GetFlag() == PackedMove::Flag::CastleShort)
+			return "O-O";
+		if (move.GetFlag() == PackedMove::Flag::CastleLong)
+			return "O-O-O";
+
+		const int from = move.GetFrom(), to = move.GetTo();
+		const PieceType type = GetType(from);
+		const bool capture = !IsEmpty(to) || move.IsEnPassant();
+
+		string res;
+		if (type == PieceType::Pawn)
+		{
+			if (capture)
+				res += FileToNotation(from % 8) + 'x';
+			res += ToNotation(FromSquare(to));
+			if (move.IsPromotion())
+				res += string("=") + PIECE_LETTERS[(int)move.GetPromotionType()];
+			return res;
+		}
+
+		res += PIECE_LETTERS[(int)type];
+
+		Bitboard others = EMPTY_BB;
+		if (type != PieceType::King)
+			others = PieceAttacks(type, turn, to, occupied) & pieces[(int)turn][(int)type] & ~SquareBB(from);
+		if (others)
+		{
+			// a pinned piece can only move along the pin
+			const int king = kingSquare[(int)turn];
+			for (Bitboard pinned = others & GetPinned(turn); pinned;)
+			{
+				int sq = PopLowestSquare(pinned);
+				if (!HasSquare(LINE[king][sq], to))
+					others &= ~SquareBB(sq);
+			}
+		}
+		if (others)
+		{
+			if (!(others & FileBB(from)))
+				res += FileToNotation(from % 8);
+			else if (!(others & RankBB(from)))
+				res += RankToNotation(from / 8);
+			else
+				res += ToNotation(FromSquare(from));
+		}
+
+		if (capture)
+			res += 'x';
+		res += ToNotation(FromSquare(to));
+		return res;
+	}
+
+	/*
+	* Legal move written in standard algebraic notation, PackedMove::None() if there is none or it is ambiguous
+	* Check marks and annotations are ignored, the moves are matched by their squares without writing any notation
+	*/
+	PackedMove ParseSan(string san) const
+	{
+		while (!san.empty() && (san.back() == '+' || san.back() == '#' || san.back() == '!' || san.back() == '?'))
+			san.pop_back();
+
+		MoveList moves;
+		GenerateLegalMoves(moves);
+
+		if (san == "O-O" || san == "0-0" || san == "O-O-O" || san == "0-0-0")
+		{
+			PackedMove::Flag flag = (san.size() == 3 ? PackedMove::Flag::CastleShort : PackedMove::Flag::CastleLong);
+			for (PackedMove m : moves)
+				if (m.GetFlag() == flag)
+					return m;
+			return PackedMove::None();
+		}
+
+		PieceType type = PieceType::Pawn;
+		if (!san.empty() && san[0] != 'P' && PIECE_LETTERS.find(san[0]) != string::npos)
+		{
+			type = PieceType(PIECE_LETTERS.find(san[0]));
+			san.erase(0, 1);
+		}
+
+		PieceType promotion = PieceType::Count;
+		if (san.size() >= 2 && PIECE_LETTERS.find(san.back()) != string::npos)
+		{
+			promotion = PieceType(PIECE_LETTERS.find(san.back()));
+			san.pop_back();
+			if (san.back() == '=')
+				san.pop_back();
+		}
+
+		if (san.size() < 2)
+			return PackedMove::None();
+		int toFile = san[san.size() - 2] - 'a', toRank = san[san.size() - 1] - '1';
+		if (toFile < 0 || toFile > 7 || toRank < 0 || toRank > 7)
+			return PackedMove::None();
+		const int to = toRank * 8 + toFile;
+
+		// what is left is the origin hint and the capture mark
+		int fromFile = -1, fromRank = -1;
+		for (char c : san.substr(0, san.size() - 2))
+			if (c >= 'a' && c <= 'h')
+				fromFile = c - 'a';
+			else if (c >= '1' && c <= '8')
+				fromRank = c - '1';
+			else if (c != 'x' && c != '-')
+				return PackedMove::None();
+
+		PackedMove res = PackedMove::None();
+		for (PackedMove m : moves)
+		{
+			int from = m.GetFrom();
+			if (m.GetTo() != to || GetType(from) != type || m.IsCastle() ||
+				(fromFile != -1 && from % 8 != fromFile) || (fromRank != -1 && from / 8 != fromRank))
+				continue;
+			if (m.IsPromotion() ? m.GetPromotionType() != promotion : promotion != PieceType::Count)
+				continue;
+			if (!res.IsNone())
+				return PackedMove::None(); // ambiguous
+			res = m;
+		}
+		return res;
+	}
+
+	/*
+	* How many times the current position occurred before
+	* Only positions since the last capture or pawn move can repeat, and only every second one has the same turn
+	*/
+	int RepetitionCount() const
+	{
+		int count = 0;
+		int first = max(0, (int)undoStack.size() - rule50);
+		for (int i = (int)undoStack.size() - 2; i >= first; i -= 2)
+			if (undoStack[i].key == key)
+				count++;
+		return count;
+	}
+	bool IsRepetition() const // for search, one repetition is enough to call it a draw
+	{
+		int first = max(0, (int)undoStack.size() - rule50);
+		for (int i = (int)undoStack.size() - 2; i >= first; i -= 2)
+			if (undoStack[i].key == key)
+				return true;
+		return false;
+	}
+
+	/*
+	* Makes a legal move of the side to move
+	* No side effects besides the position itself and no heap allocation,
+	* everything needed to take the move back goes to a small undo record
+	*/
+	void DoMove(PackedMove move)
+	{
+		const PlayerTeam team = turn;
+		const PlayerTeam enemy = OtherTeam(team);
+		const int from = move.GetFrom(), to = move.GetTo();
+		const int forward = (team == PlayerTeam::White ? 8 : -8);
+		const int base = (team == PlayerTeam::White ? 0 : 56);
+
+		UndoInfo undo;
+		undo.move = move;
+		undo.captured = PieceType::Count;
+		undo.castlingRights = castlingRights;
+		undo.epSquare = epSquare;
+		undo.rule50 = rule50;
+		undo.key = key;
+
+		PieceType type = GetType(from);
+
+		if (move.IsEnPassant())
+		{
+			undo.captured = PieceType::Pawn;
+			RemovePiece(to - forward, PieceType::Pawn, enemy);
+		}
+		else if (!IsEmpty(to))
+		{
+			undo.captured = GetType(to);
+			RemovePiece(to, undo.captured, enemy);
+		}
+
+		RemovePiece(from, type, team);
+		AddPiece(to, (move.IsPromotion() ? move.GetPromotionType() : type), team);
+
+		if (move.GetFlag() == PackedMove::Flag::CastleShort)
+		{
+			RemovePiece(base + 7, PieceType::Rook, team);
+			AddPiece(base + 5, PieceType::Rook, team);
+		}
+		else if (move.GetFlag() == PackedMove::Flag::CastleLong)
+		{
+			RemovePiece(base, PieceType::Rook, team);
+			AddPiece(base + 3, PieceType::Rook, team);
+		}
+
+		if (castlingRights)
+			SetCastlingRights(castlingRights & CASTLING_MASK[from] & CASTLING_MASK[to]);
+
+		// only kept when an enemy pawn can take it, so equal positions get equal keys
+		int ep = -1;
+		if (move.GetFlag() == PackedMove::Flag::DoublePush && (PawnAttacks(team, from + forward) & pieces[(int)enemy][(int)PieceType::Pawn]))
+			ep = from + forward;
+		SetEpSquare(ep);
+		SetTurn(enemy);
+
+		rule50 = (type == PieceType::Pawn || undo.captured != PieceType::Count ? 0 : rule50 + 1);
+
+		undoStack.push_back(undo);
+		UpdateAttacks();
+	}
+	void UndoMove()
+	{
+		const UndoInfo undo = undoStack.back();
+		undoStack.pop_back();
+
+		const PlayerTeam team = OtherTeam(turn);
+		const PlayerTeam enemy = turn;
+		const PackedMove move = undo.move;
+		const int from = move.GetFrom(), to = move.GetTo();
+		const int forward = (team == PlayerTeam::White ? 8 : -8);
+		const int base = (team == PlayerTeam::White ? 0 : 56);
+
+		PieceType type = GetType(to);
+		RemovePiece(to, type, team);
+		AddPiece(from, (move.IsPromotion() ? PieceType::Pawn : type), team);
+
+		if (move.GetFlag() == PackedMove::Flag::CastleShort)
+		{
+			RemovePiece(base + 5, PieceType::Rook, team);
+			AddPiece(base + 7, PieceType::Rook, team);
+		}
+		else if (move.GetFlag() == PackedMove::Flag::CastleLong)
+		{
+			RemovePiece(base + 3, PieceType::Rook, team);
+			AddPiece(base, PieceType::Rook, team);
+		}
+
+		if (undo.captured != PieceType::Count)
+			AddPiece((move.IsEnPassant() ? to - forward : to), undo.captured, enemy);
+
+		castlingRights = undo.castlingRights;
+		epSquare = undo.epSquare;
+		rule50 = undo.rule50;
+		turn = team;
+		key = undo.key;
+
+		UpdateAttacks();
+	}
+};
\ No newline at end of file
@@ -0,0 +1,144 @@
+#include <iostream>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <memory>
+
+#include "Search.h"
+
+using namespace std;
+
+
+/*
+* Headless search, no GUI needed
+* engine				searches the benchmark positions and prints the total speed
+* engine "fen"			searches the position
+* Options, anywhere after the program name:
+* -depth plies			stops after that depth (64 by default)
+* -nodes count			stops after about that many nodes
+* -time milliseconds	stops after about that time
+* -hash megabytes		size of the transposition table (16 by default, 0 for none)
+* -t threads			searches with that many threads sharing the table (1 by default)
+* Without options the benchmark searches to depth 6
+*/
+
+const vector<string> BENCH_POSITIONS = {
+	"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+	"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+	"8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+	"r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+	"rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+	"r1bqkb1r/pppp1ppp/2n2n2/4p2Q/2B1P3/8/PPPP1PPP/RNB1K1NR w KQkq - 4 4",
+};
+
+double SecondsSince(chrono::steady_clock::time_point start)
+{
+	return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+string ScoreToString(int score)
+{
+	if (!IsMateScore(score))
+		return "cp " + to_string(score);
+	int plies = MATE_SCORE - abs(score);
+	return "mate " + to_string(score > 0 ? (plies + 1) / 2 : -plies / 2);
+}
+
+// Principal variation in standard algebraic notation
+string PvToString(const BoardState& root, const vector<PackedMove>& pv)
+{
+	ChessPosition position(root);
+	string res;
+	for (PackedMove move : pv)
+	{
+		res += (res.empty() ? "" : " ") + position.ToSan(move);
+		position.DoMove(move);
+	}
+	return res;
+}
+
+long long SearchPosition(const string& fen, const SearchLimits& limits, int threads, TranspositionTable* table)
+{
+	ChessPosition position;
+	position.LoadFen(fen);
+
+	// a cleared table per position, so every search gives the same result on its own
+	if (table != nullptr)
+		table->Clear();
+
+	auto start = chrono::steady_clock::now();
+	SearchResult res = ParallelSearch(position.GetSnapshot(), limits, threads, table);
+	double time = SecondsSince(start);
+
+	cout << fen << "\n\tdepth " << res.depth << " " << ScoreToString(res.score) << ", " << res.nodes << " nodes, "
+		<< time << " s, " << (long long)(res.nodes / max(time, 1e-9)) << " nps";
+	if (table != nullptr)
+		cout << ", hashfull " << table->Usage() << " permille";
+	cout << "\n\tpv " << PvToString(position.GetSnapshot(), res.pv) << "\n";
+	if (threads > 1)
+	{
+		cout << "\tnodes by thread";
+		for (long long nodes : res.threadNodes)
+			cout << " " << nodes;
+		cout << "\n";
+	}
+	return res.nodes;
+}
+
+int main(int argc, char** argv)
+{
+	try
+	{
+		SearchLimits limits;
+		bool limited = false;
+		int hashMegabytes = 16;
+		int threads = 1;
+		vector<string> args;
+		for (int i = 1; i < argc; i++)
+		{
+			string arg = argv[i];
+			if ((arg == "-t" || arg == "-hash") && i + 1 < argc)
+				(arg == "-t" ? threads : hashMegabytes) = stoi(argv[++i]);
+			else if ((arg == "-depth" || arg == "-nodes" || arg == "-time") && i + 1 < argc)
+			{
+				if (arg == "-depth") limits.depth = stoi(argv[++i]);
+				else if (arg == "-nodes") limits.nodes = stoll(argv[++i]);
+				else limits.milliseconds = stoi(argv[++i]);
+				limited = true;
+			}
+			else args.push_back(arg);
+		}
+		if (limits.depth < 1 || limits.nodes < 0 || limits.milliseconds < 0 || hashMegabytes < 0 || threads < 1)
+			throw "Invalid options";
+
+		unique_ptr<TranspositionTable> table(hashMegabytes > 0 ? new TranspositionTable(hashMegabytes) : nullptr);
+
+		if (args.size() > 0)
+		{
+			SearchPosition(args[0], limits, threads, table.get());
+			return 0;
+		}
+
+		if (!limited)
+			limits.depth = 6;
+
+		auto start = chrono::steady_clock::now();
+		long long totalNodes = 0;
+		for (const string& fen : BENCH_POSITIONS)
+			totalNodes += SearchPosition(fen, limits, threads, table.get());
+		double totalTime = SecondsSince(start);
+
+		cout << "total: " << totalNodes << " nodes, " << totalTime << " s, "
+			<< (long long)(totalNodes / max(totalTime, 1e-9)) << " nps\n";
+		return 0;
+	}
+	catch (const char* error)
+	{
+		cerr << error << "\n";
+	}
+	catch (const exception& error)
+	{
+		cerr << error.what() << "\n";
+	}
+	return 2;
+}
\ No newline at end of file
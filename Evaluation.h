@@ -0,0 +1,168 @@
+#pragma once
+
+#include <algorithm>
+
+#include "ChessPosition.h"
+#include "PackedMove.h"
+
+using namespace std;
+
+
+/*
+* Static evaluation in centipawns: material plus a bonus for the square of every piece
+* Tables are for white from a1 to h8, black reads them mirrored
+*/
+
+const int PIECE_VALUES[(int)PieceType::Count + 1] = { 100, 320, 330, 500, 900, 0, 0 }; // by PieceType, an empty square is worth 0
+
+const int PIECE_SQUARE_TABLES[(int)PieceType::Count][64] = {
+	{ // pawn
+		  0,   0,   0,   0,   0,   0,   0,   0,
+		  5,  10,  10, -20, -20,  10,  10,   5,
+		  5,  -5, -10,   0,   0, -10,  -5,   5,
+		  0,   0,   0,  20,  20,   0,   0,   0,
+		  5,   5,  10,  25,  25,  10,   5,   5,
+		 10,  10,  20,  30,  30,  20,  10,  10,
+		 50,  50,  50,  50,  50,  50,  50,  50,
+		  0,   0,   0,   0,   0,   0,   0,   0,
+	},
+	{ // knight
+		-50, -40, -30, -30, -30, -30, -40, -50,
+		-40, -20,   0,   5,   5,   0, -20, -40,
+		-30,   5,  10,  15,  15,  10,   5, -30,
+		-30,   0,  15,  20,  20,  15,   0, -30,
+		-30,   5,  15,  20,  20,  15,   5, -30,
+		-30,   0,  10,  15,  15,  10,   0, -30,
+		-40, -20,   0,   0,   0,   0, -20, -40,
+		-50, -40, -30, -30, -30, -30, -40, -50,
+	},
+	{ // bishop
+		-20, -10, -10, -10, -10, -10, -10, -20,
+		-10,   5,   0,   0,   0,   0,   5, -10,
+		-10,  10,  10,  10,  10,  10,  10, -10,
+		-10,   0,  10,  10,  10,  10,   0, -10,
+		-10,   5,   5,  10,  10,   5,   5, -10,
+		-10,   0,   5,  10,  10,   5,   0, -10,
+		-10,   0,   0,   0,   0,   0,   0, -10,
+		-20, -10, -10, -10, -10, -10, -10, -20,
+	},
+	{ // rook
+		  0,   0,   0,   5,   5,   0,   0,   0,
+		 -5,   0,   0,   0,   0,   0,   0,  -5,
+		 -5,   0,   0,   0,   0,   0,   0,  -5,
+		 -5,   0,   0,   0,   0,   0,   0,  -5,
+		 -5,   0,   0,   0,   0,   0,   0,  -5,
+		 -5,   0,   0,   0,   0,   0,   0,  -5,
+		  5,  10,  10,  10,  10,  10,  10,   5,
+		  0,   0,   0,   0,   0,   0,   0,   0,
+	},
+	{ // queen
+		-20, -10, -10,  -5,  -5, -10, -10, -20,
+		-10,   0,   5,   0,   0,   0,   0, -10,
+		-10,   5,   5,   5,   5,   5,   0, -10,
+		  0,   0,   5,   5,   5,   5,   0,  -5,
+		 -5,   0,   5,   5,   5,   5,   0,  -5,
+		-10,   0,   5,   5,   5,   5,   0, -10,
+		-10,   0,   0,   0,   0,   0,   0, -10,
+		-20, -10, -10,  -5,  -5, -10, -10, -20,
+	},
+	{ // king, stays behind its pawns
+		 20,  30,  10,   0,   0,  10,  30,  20,
+		 20,  20,   0,   0,   0,   0,  20,  20,
+		-10, -20, -20, -20, -20, -20, -20, -10,
+		-20, -30, -30, -40, -40, -30, -30, -20,
+		-30, -40, -40, -50, -50, -40, -40, -30,
+		-30, -40, -40, -50, -50, -40, -40, -30,
+		-30, -40, -40, -50, -50, -40, -40, -30,
+		-30, -40, -40, -50, -50, -40, -40, -30,
+	},
+};
+
+// Score of the side to move
+int Evaluate(const ChessPosition& position)
+{
+	int score = 0;
+	for (int t = 0; t < (int)PieceType::Count; t++)
+	{
+		for (Bitboard bb = position.GetPieces(PlayerTeam::White, PieceType(t)); bb;)
+			score += PIECE_VALUES[t] + PIECE_SQUARE_TABLES[t][PopLowestSquare(bb)];
+		for (Bitboard bb = position.GetPieces(PlayerTeam::Black, PieceType(t)); bb;)
+			score -= PIECE_VALUES[t] + PIECE_SQUARE_TABLES[t][PopLowestSquare(bb) ^ 56];
+	}
+	return (position.GetTurn() == PlayerTeam::White ? score : -score);
+}
+
+/*
+* Static exchange evaluation: material won by move if both sides then keep capturing on its square,
+* every time with their least valuable piece, and either side may stop when going on would lose
+* Attackers come from attackers-to-square lookups on the shrinking occupancy, so sliders behind the pieces
+* that captured join in; pins are ignored. Works for a capture by either team, not only the side to move
+* A pawn that captures on rank 1 or 8 counts as a queen from then on
+*/
+int SEE(const ChessPosition& position, PackedMove move)
+{
+	if (move.IsCastle())
+		return 0;
+
+	const int from = move.GetFrom(), to = move.GetTo();
+	const PlayerTeam team = position.GetTeam(from);
+	const Bitboard diagonal = position.GetPieces(PieceType::Bishop) | position.GetPieces(PieceType::Queen);
+	const Bitboard straight = position.GetPieces(PieceType::Rook) | position.GetPieces(PieceType::Queen);
+	const bool promotes = HasSquare(RankBB(0) | RankBB(56), to);
+	const int promotionGain = PIECE_VALUES[(int)PieceType::Queen] - PIECE_VALUES[(int)PieceType::Pawn];
+
+	int gain[32];
+	int d = 0;
+	Bitboard occupied = position.GetOccupied() ^ SquareBB(from);
+
+	PieceType onSquare = position.GetType(from);
+	if (move.IsEnPassant())
+	{
+		gain[0] = PIECE_VALUES[(int)PieceType::Pawn];
+		occupied ^= SquareBB(to + (team == PlayerTeam::White ? -8 : 8));
+	}
+	else
+		gain[0] = PIECE_VALUES[(int)position.GetType(to)];
+	if (move.IsPromotion())
+	{
+		onSquare = move.GetPromotionType();
+		gain[0] += PIECE_VALUES[(int)onSquare] - PIECE_VALUES[(int)PieceType::Pawn];
+	}
+
+	Bitboard attackers = position.AttackersTo(to, occupied) & occupied;
+	PlayerTeam side = OtherTeam(team);
+	while (true)
+	{
+		Bitboard own = attackers & position.GetPieces(side);
+		if (!own)
+			break;
+
+		int type = (int)PieceType::Pawn;
+		Bitboard bb = EMPTY_BB;
+		for (; type <= (int)PieceType::King; type++)
+			if ((bb = own & position.GetPieces(side, PieceType(type))))
+				break;
+		// the king can't take a defended piece
+		if (type == (int)PieceType::King && (attackers & position.GetPieces(OtherTeam(side))))
+			break;
+
+		d++;
+		gain[d] = PIECE_VALUES[(int)onSquare] - gain[d - 1];
+		onSquare = PieceType(type);
+		if (promotes && onSquare == PieceType::Pawn)
+		{
+			gain[d] += promotionGain;
+			onSquare = PieceType::Queen;
+		}
+
+		occupied ^= SquareBB(LowestSquare(bb));
+		attackers |= (BishopAttacks(to, occupied) & diagonal) | (RookAttacks(to, occupied) & straight);
+		attackers &= occupied;
+		side = OtherTeam(side);
+	}
+
+	// from the last capture back, each side takes the better of capturing and stopping
+	for (; d > 0; d--)
+		gain[d - 1] = -max(-gain[d - 1], gain[d]);
+	return gain[0];
+}
\ No newline at end of file
@@ -195,7 +195,7 @@ class Graphics
 				notation.setPosition(Point<float>(
 					SQUARE_SIZE.x * board->SIZE.x + SQUARE_SIZE.x / 3.f + 24,
 					SQUARE_SIZE.y * 1.5f + i * 24));
-				notation.setString(moves[notationOffset + i].notation);
+				notation.setString(board->GetNotation(notationOffset + i));
 				window.draw(notation);
 			}
 		}
@@ -0,0 +1,208 @@
+#pragma once
+
+#include "ChessPosition.h"
+#include "PackedMove.h"
+#include "Evaluation.h"
+
+using namespace std;
+
+
+/*
+* What a search learns about quiet moves as it goes, every thread keeps its own
+* Killers are the last two quiet moves that cut off at a ply, history counts cutoffs of a move by its squares
+*/
+struct MoveHistory
+{
+	static const int MAX_PLY = 128; // deeper than any search goes
+
+	PackedMove killers[MAX_PLY][2];
+	int history[2][64][64];	// [team][from][to]
+
+	void Clear()
+	{
+		for (int i = 0; i < MAX_PLY; i++)
+			killers[i][0] = killers[i][1] = PackedMove::None();
+		for (int t = 0; t < 2; t++)
+			for (int from = 0; from < 64; from++)
+				for (int to = 0; to < 64; to++)
+					history[t][from][to] = 0;
+	}
+
+	// Quiet move that made a search at depth fail high
+	void AddCutoff(PlayerTeam team, PackedMove move, int ply, int depth)
+	{
+		if (killers[ply][0] != move)
+		{
+			killers[ply][1] = killers[ply][0];
+			killers[ply][0] = move;
+		}
+
+		int& value = history[(int)team][move.GetFrom()][move.GetTo()];
+		value += depth * depth;
+		if (value >= (1 << 24)) // keep the scale, old cutoffs matter less
+			for (int t = 0; t < 2; t++)
+				for (int from = 0; from < 64; from++)
+					for (int to = 0; to < 64; to++)
+						history[t][from][to] /= 2;
+	}
+};
+
+// Captures, en passant and promotions, the moves MoveKind::Captures generates
+bool IsCaptureOrPromotion(const ChessPosition& position, PackedMove move)
+{
+	return !position.IsEmpty(move.GetTo()) || move.IsEnPassant() || move.IsPromotion();
+}
+
+
+/*
+* Hands out the legal moves of a position best first, generating them in stages:
+* the hash move, captures by most valuable victim and least valuable attacker, killers, quiet moves by history,
+* and last the captures that lose material by static exchange evaluation
+* A cutoff on an early move saves generating the rest
+* With capturesOnly, for quiescence search, only the captures that don't lose material are handed out
+*/
+class MovePicker
+{
+	enum class Stage
+	{
+		HashMove,
+		GenerateCaptures,
+		Captures,
+		Killers,
+		GenerateQuiets,
+		Quiets,
+		BadCaptures,
+		Done
+	};
+
+	const ChessPosition& position;
+	const MoveHistory& history;
+	const int ply;
+	const PackedMove hashMove;
+	const bool capturesOnly;
+
+	Stage stage;
+	MoveList moves;
+	int scores[MoveList::MAX_MOVES];
+	int current;
+	int killer;
+	MoveList badCaptures;	// put aside by the captures stage
+	int badCurrent;
+
+	int CaptureScore(PackedMove move) const
+	{
+		int victim = (move.IsEnPassant() ? (int)PieceType::Pawn : (int)position.GetType(move.GetTo())); // Count if empty
+		int score = PIECE_VALUES[victim] * 8 - (int)position.GetType(move.GetFrom());
+		if (move.IsPromotion())
+			score += PIECE_VALUES[(int)move.GetPromotionType()] * 8;
+		return score;
+	}
+
+	// Best of the moves not handed out yet, selection sort one step at a time since most nodes only need a few
+	PackedMove PickBest()
+	{
+		int best = current;
+		for (int i = current + 1; i < moves.Size(); i++)
+			if (scores[i] > scores[best])
+				best = i;
+		swap(moves[current], moves[best]);
+		swap(scores[current], scores[best]);
+		return moves[current++];
+	}
+
+	bool IsKiller(PackedMove move) const
+	{
+		return move == history.killers[ply][0] || move == history.killers[ply][1];
+	}
+
+	// Taking a piece at least as valuable as the one that takes can't lose, so SEE is only needed otherwise
+	bool LosesMaterial(PackedMove move) const
+	{
+		if (!move.IsPromotion() && PIECE_VALUES[(int)position.GetType(move.GetTo())] >= PIECE_VALUES[(int)position.GetType(move.GetFrom())])
+			return false;
+		return SEE(position, move) < 0;
+	}
+public:
+	MovePicker(const ChessPosition& position, PackedMove hashMove, const MoveHistory& history, int ply, bool capturesOnly = false) :
+		position(position), history(history), ply(ply), hashMove(hashMove), capturesOnly(capturesOnly),
+		stage(Stage::HashMove), moves(), current(0), killer(0), badCaptures(), badCurrent(0)
+	{}
+
+	// PackedMove::None() when there are no moves left
+	PackedMove Next()
+	{
+		switch (stage)
+		{
+		case Stage::HashMove:
+			stage = Stage::GenerateCaptures;
+			if (position.IsLegal(hashMove))
+				return hashMove;
+			[[fallthrough]];
+
+		case Stage::GenerateCaptures:
+			moves.Clear();
+			position.GenerateLegalMoves(moves, MoveKind::Captures);
+			for (int i = 0; i < moves.Size(); i++)
+				scores[i] = CaptureScore(moves[i]);
+			current = 0;
+			stage = Stage::Captures;
+			[[fallthrough]];
+
+		case Stage::Captures:
+			while (current < moves.Size())
+			{
+				PackedMove move = PickBest();
+				if (move == hashMove)
+					continue;
+				if (LosesMaterial(move))
+					badCaptures.Push(move);
+				else
+					return move;
+			}
+			stage = (capturesOnly ? Stage::Done : Stage::Killers);
+			if (capturesOnly)
+				break;
+			[[fallthrough]];
+
+		case Stage::Killers:
+			while (killer < 2)
+			{
+				PackedMove move = history.killers[ply][killer++];
+				// a killer comes from another position, so it may be illegal or a capture here
+				if (move != hashMove && !move.IsNone() && !IsCaptureOrPromotion(position, move) && position.IsLegal(move))
+					return move;
+			}
+			stage = Stage::GenerateQuiets;
+			[[fallthrough]];
+
+		case Stage::GenerateQuiets:
+			moves.Clear();
+			position.GenerateLegalMoves(moves, MoveKind::Quiets);
+			for (int i = 0; i < moves.Size(); i++)
+				scores[i] = history.history[(int)position.GetTurn()][moves[i].GetFrom()][moves[i].GetTo()];
+			current = 0;
+			stage = Stage::Quiets;
+			[[fallthrough]];
+
+		case Stage::Quiets:
+			while (current < moves.Size())
+			{
+				PackedMove move = PickBest();
+				if (move != hashMove && !IsKiller(move))
+					return move;
+			}
+			stage = Stage::BadCaptures;
+			[[fallthrough]];
+
+		case Stage::BadCaptures:
+			if (badCurrent < badCaptures.Size())
+				return badCaptures[badCurrent++];
+			stage = Stage::Done;
+			[[fallthrough]];
+
+		case Stage::Done:
+			break;
+		}
+		return PackedMove::None();
+	}
+};
\ No newline at end of file
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <string>
+#include <deque>
+#include <unordered_map>
+#include <mutex>
+
+using namespace std;
+
+
+/*
+* Every distinct notation string is kept once and moves refer to it by index
+* A few thousand strings like "Nf3" or "exd5+" cover almost every move of every game
+* Shared by all boards, so it is locked; strings are never removed, so references to them stay valid
+*/
+class NotationTable
+{
+	deque<string> strings;
+	unordered_map<string, int> indices;
+	mutable mutex lock;
+
+	NotationTable() {}
+public:
+	static NotationTable& Get()
+	{
+		static NotationTable table;
+		return table;
+	}
+
+	int Add(const string& notation)
+	{
+		lock_guard<mutex> guard(lock);
+		auto it = indices.find(notation);
+		if (it != indices.end())
+			return it->second;
+
+		strings.push_back(notation);
+		indices.emplace(notation, (int)strings.size() - 1);
+		return (int)strings.size() - 1;
+	}
+	const string& GetString(int index) const
+	{
+		lock_guard<mutex> guard(lock);
+		return strings[index];
+	}
+};
\ No newline at end of file
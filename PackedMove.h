@@ -0,0 +1,180 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "Other.h"
+#include "Bitboard.h"
+
+using namespace std;
+
+
+/*
+* Move packed into 16 bits: from square (6), to square (6) and flags (4)
+* Used by move generation, PieceMove is only made when a move is recorded
+*/
+class PackedMove
+{
+	uint16_t data;
+public:
+	enum class Flag
+	{
+		Quiet = 0,
+		DoublePush,
+		CastleShort,
+		CastleLong,
+		EnPassant,
+
+		PromotionKnight = 8, // promotions have bit 3 set
+		PromotionBishop,
+		PromotionRook,
+		PromotionQueen
+	};
+
+	PackedMove() = default; // left uninitialized, so MoveList costs nothing to create
+	PackedMove(int from, int to, Flag flag = Flag::Quiet) :
+		data((uint16_t)(from | (to << 6) | ((int)flag << 12)))
+	{}
+
+	static PackedMove None()
+	{
+		return PackedMove(0, 0);
+	}
+
+	int GetFrom() const
+	{
+		return data & 63;
+	}
+	int GetTo() const
+	{
+		return (data >> 6) & 63;
+	}
+	Flag GetFlag() const
+	{
+		return Flag(data >> 12);
+	}
+
+	bool IsPromotion() const
+	{
+		return (data >> 12) & 8;
+	}
+	PieceType GetPromotionType() const // move must be a promotion
+	{
+		return PieceType((int)PieceType::Knight + ((data >> 12) & 3));
+	}
+	bool IsCastle() const
+	{
+		return GetFlag() == Flag::CastleShort || GetFlag() == Flag::CastleLong;
+	}
+	bool IsEnPassant() const
+	{
+		return GetFlag() == Flag::EnPassant;
+	}
+
+	bool IsNone() const
+	{
+		return data == 0;
+	}
+
+	// the 16 bits themselves, for tables that store moves
+	uint16_t GetData() const
+	{
+		return data;
+	}
+	static PackedMove FromData(uint16_t data)
+	{
+		PackedMove res;
+		res.data = data;
+		return res;
+	}
+
+	// Coordinate notation, e.g. "e2e4" or "e7e8q"
+	string ToString() const
+	{
+		string res = ToNotation(FromSquare(GetFrom())) + ToNotation(FromSquare(GetTo()));
+		if (IsPromotion())
+			res += "nbrq"[(int)GetPromotionType() - (int)PieceType::Knight];
+		return res;
+	}
+
+	bool operator== (const PackedMove& oth) const
+	{
+		return data == oth.data;
+	}
+	bool operator!= (const PackedMove& oth) const
+	{
+		return data != oth.data;
+	}
+};
+
+PackedMove::Flag PromotionFlag(PieceType type)
+{
+	return PackedMove::Flag((int)PackedMove::Flag::PromotionKnight + (int)type - (int)PieceType::Knight);
+}
+
+
+/*
+* Fixed-capacity list of moves, lives on the stack
+*/
+class MoveList
+{
+public:
+	static const int MAX_MOVES = 256;
+private:
+	PackedMove moves[MAX_MOVES];
+	int size;
+public:
+	MoveList() : size(0) {}
+
+	void Push(PackedMove move)
+	{
+		moves[size++] = move;
+	}
+	void Clear()
+	{
+		size = 0;
+	}
+
+	int Size() const
+	{
+		return size;
+	}
+	bool IsEmpty() const
+	{
+		return size == 0;
+	}
+
+	PackedMove& operator[] (int i)
+	{
+		return moves[i];
+	}
+	const PackedMove& operator[] (int i) const
+	{
+		return moves[i];
+	}
+
+	PackedMove* begin()
+	{
+		return moves;
+	}
+	PackedMove* end()
+	{
+		return moves + size;
+	}
+	const PackedMove* begin() const
+	{
+		return moves;
+	}
+	const PackedMove* end() const
+	{
+		return moves + size;
+	}
+
+	bool Contains(PackedMove move) const
+	{
+		for (int i = 0; i < size; i++)
+			if (moves[i] == move)
+				return true;
+		return false;
+	}
+};
\ No newline at end of file
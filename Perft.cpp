@@ -0,0 +1,168 @@
+#include <iostream>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <memory>
+
+#include "Perft.h"
+
+using namespace std;
+
+
+/*
+* Headless move generator benchmark
+* perft [depth]			runs the standard positions, checks node counts and prints speed
+* perft depth "fen"		prints node counts of every root move of the position
+* Options, anywhere after the program name:
+* -t threads			splits the first two plies over threads (1 by default)
+* -hash megabytes		shares counts of transposed subtrees through a table of that size (none by default)
+*/
+
+struct PerftPosition
+{
+	string fen;
+	vector<long long> nodes; // expected, by depth starting from 1
+};
+
+const vector<PerftPosition> PERFT_POSITIONS = {
+	{ "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+		{ 20, 400, 8902, 197281, 4865609, 119060324 } },
+	{ "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+		{ 48, 2039, 97862, 4085603, 193690690 } },
+	{ "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+		{ 14, 191, 2812, 43238, 674624, 11030083 } },
+	{ "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+		{ 6, 264, 9467, 422333, 15833292 } },
+	{ "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+		{ 44, 1486, 62379, 2103487, 89941194 } },
+};
+
+// Positions the generator can't work on, LoadFen must refuse them
+const vector<string> INVALID_FENS = {
+	"8/8/8/8/8/8/8/4K3 w - - 0 1",				// no black king
+	"4k3/8/8/8/8/8/8/3KK3 w - - 0 1",			// two white kings
+	"4k3/8/8/8/8/8/8/P3K3 w - - 0 1",			// pawn on the first rank
+	"4k3/8/8/8/8/8/8/4K3/8 w - - 0 1",			// nine ranks
+	"4k3/8/8/8/8/8/8/4K4 w - - 0 1",			// nine files
+	"4k3/8/8/8/8/8/8/4R1K1 w - - 0 1",			// black, not to move, is in check
+};
+
+double SecondsSince(chrono::steady_clock::time_point start)
+{
+	return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+struct PerftOptions
+{
+	int threads = 1;
+	int hashMegabytes = 0;
+};
+
+int RunSuite(int depth, const PerftOptions& options)
+{
+	ChessPosition position;
+	long long totalNodes = 0;
+	double totalTime = 0;
+	bool ok = true;
+
+	for (const string& fen : INVALID_FENS)
+	{
+		bool rejected = false;
+		try
+		{
+			position.LoadFen(fen);
+		}
+		catch (const char*)
+		{
+			rejected = true;
+		}
+		if (!rejected)
+			cout << fen << "\n\tFAILED, accepted an invalid FEN\n";
+		ok &= rejected;
+	}
+
+	for (const PerftPosition& test : PERFT_POSITIONS)
+	{
+		position.LoadFen(test.fen);
+		int d = min(depth, (int)test.nodes.size());
+
+		auto start = chrono::steady_clock::now();
+		long long nodes;
+		if (options.threads == 1 && options.hashMegabytes == 0)
+			nodes = Perft(position, d);
+		else
+		{
+			// a fresh table per position, so every count is checked on its own
+			unique_ptr<PerftTable> table(options.hashMegabytes > 0 ? new PerftTable(options.hashMegabytes) : nullptr);
+			nodes = ParallelPerft(position, d, options.threads, table.get());
+		}
+		double time = SecondsSince(start);
+
+		bool correct = (nodes == test.nodes[d - 1]);
+		ok &= correct;
+		totalNodes += nodes;
+		totalTime += time;
+
+		cout << test.fen << "\n\tdepth " << d << ": " << nodes << " nodes, " << time << " s, "
+			<< (long long)(nodes / max(time, 1e-9)) << " nps" << (correct ? "" : "  FAILED, expected " + to_string(test.nodes[d - 1])) << "\n";
+	}
+
+	cout << "total: " << totalNodes << " nodes, " << totalTime << " s, "
+		<< (long long)(totalNodes / max(totalTime, 1e-9)) << " nps\n";
+	return (ok ? 0 : 1);
+}
+
+int RunDivide(int depth, const string& fen, const PerftOptions& options)
+{
+	ChessPosition position;
+	position.LoadFen(fen);
+
+	unique_ptr<PerftTable> table(options.hashMegabytes > 0 ? new PerftTable(options.hashMegabytes) : nullptr);
+
+	auto start = chrono::steady_clock::now();
+	long long total = 0;
+	for (auto& [move, nodes] : ParallelDivide(position, depth, options.threads, table.get()))
+	{
+		cout << move.ToString() << ": " << nodes << "\n";
+		total += nodes;
+	}
+	double time = SecondsSince(start);
+
+	cout << "\ntotal: " << total << " nodes, " << time << " s, " << (long long)(total / max(time, 1e-9)) << " nps\n";
+	return 0;
+}
+
+int main(int argc, char** argv)
+{
+	try
+	{
+		PerftOptions options;
+		vector<string> args;
+		for (int i = 1; i < argc; i++)
+		{
+			string arg = argv[i];
+			if ((arg == "-t" || arg == "-hash") && i + 1 < argc)
+				(arg == "-t" ? options.threads : options.hashMegabytes) = stoi(argv[++i]);
+			else args.push_back(arg);
+		}
+		if (options.threads < 1 || options.hashMegabytes < 0)
+			throw "Invalid options";
+
+		int depth = (args.size() > 0 ? stoi(args[0]) : 5);
+		if (depth < 1)
+			throw "Depth must be positive";
+
+		if (args.size() > 1)
+			return RunDivide(depth, args[1], options);
+		return RunSuite(depth, options);
+	}
+	catch (const char* error)
+	{
+		cerr << error << "\n";
+	}
+	catch (const exception& error)
+	{
+		cerr << error.what() << "\n";
+	}
+	return 2;
+}
\ No newline at end of file
@@ -0,0 +1,192 @@
+#pragma once
+
+#include <vector>
+#include <utility>
+#include <atomic>
+#include <thread>
+#include <cstdint>
+
+#include "ChessPosition.h"
+#include "PackedMove.h"
+#include "AtomicEntry.h"
+
+using namespace std;
+
+
+/*
+* Counts leaf nodes of the legal move tree, the standard check of a move generator
+* The last ply is counted from the size of the move list, without making the moves
+*/
+long long Perft(ChessPosition& position, int depth)
+{
+	if (depth == 0)
+		return 1;
+
+	MoveList moves;
+	position.GenerateLegalMoves(moves);
+	if (depth == 1)
+		return moves.Size();
+
+	long long nodes = 0;
+	for (PackedMove move : moves)
+	{
+		position.DoMove(move);
+		nodes += Perft(position, depth - 1);
+		position.UndoMove();
+	}
+	return nodes;
+}
+
+// Perft split by the root moves, to find the move where a wrong count comes from
+vector<pair<PackedMove, long long> > Divide(ChessPosition& position, int depth)
+{
+	vector<pair<PackedMove, long long> > res;
+
+	MoveList moves;
+	position.GenerateLegalMoves(moves);
+	for (PackedMove move : moves)
+	{
+		position.DoMove(move);
+		res.emplace_back(move, Perft(position, depth - 1));
+		position.UndoMove();
+	}
+	return res;
+}
+
+
+/*
+* Node counts of subtrees already counted, shared by all perft threads without locks, see AtomicEntry
+* An entry's data is nodes << 8 | depth
+*/
+class PerftTable
+{
+	vector<AtomicEntry> entries;
+	uint64_t mask;
+public:
+	explicit PerftTable(size_t megabytes)
+	{
+		size_t count = 1;
+		while (count * 2 * sizeof(AtomicEntry) <= megabytes * 1024 * 1024)
+			count *= 2;
+		entries = vector<AtomicEntry>(count);
+		mask = count - 1;
+		Clear();
+	}
+
+	void Clear()
+	{
+		for (AtomicEntry& e : entries)
+			e.Clear();
+	}
+
+	bool Probe(uint64_t key, int depth, long long& nodes) const
+	{
+		uint64_t data;
+		if (!entries[key & mask].Load(key, data) || (int)(data & 0xFF) != depth)
+			return false;
+		nodes = (long long)(data >> 8);
+		return true;
+	}
+	void Store(uint64_t key, int depth, long long nodes)
+	{
+		entries[key & mask].Store(key, ((uint64_t)nodes << 8) | (uint64_t)depth);
+	}
+};
+
+long long Perft(ChessPosition& position, int depth, PerftTable& table)
+{
+	if (depth <= 1)
+		return Perft(position, depth);
+
+	long long nodes = 0;
+	if (table.Probe(position.GetKey(), depth, nodes))
+		return nodes;
+
+	MoveList moves;
+	position.GenerateLegalMoves(moves);
+	for (PackedMove move : moves)
+	{
+		position.DoMove(move);
+		nodes += Perft(position, depth - 1, table);
+		position.UndoMove();
+	}
+
+	table.Store(position.GetKey(), depth, nodes);
+	return nodes;
+}
+
+/*
+* Divide with the work split over threads, every thread counts on its own copy of the position
+* Work items are the moves of the first two plies, so even a few root moves keep all threads busy
+* table may be null to count without it, with one thread and no table this is plain Divide
+*/
+vector<pair<PackedMove, long long> > ParallelDivide(const ChessPosition& position, int depth, int threads, PerftTable* table)
+{
+	ChessPosition root = position;
+	if (threads == 1 && table == nullptr)
+		return Divide(root, depth);
+
+	MoveList rootMoves;
+	root.GenerateLegalMoves(rootMoves);
+
+	vector<pair<PackedMove, long long> > res;
+	for (PackedMove move : rootMoves)
+		res.emplace_back(move, (depth == 1 ? 1 : 0));
+	if (depth == 1)
+		return res;
+
+	struct Item
+	{
+		int root;
+		PackedMove move;
+	};
+	vector<Item> items;
+	for (int i = 0; i < rootMoves.Size(); i++)
+	{
+		MoveList moves;
+		root.DoMove(rootMoves[i]);
+		root.GenerateLegalMoves(moves);
+		root.UndoMove();
+
+		for (PackedMove move : moves)
+			items.push_back({ i, move });
+	}
+
+	vector<atomic<long long> > counts(rootMoves.Size());
+	atomic<size_t> next = 0;
+
+	auto worker = [&]()
+	{
+		ChessPosition local(root.GetSnapshot());
+		for (size_t i = next++; i < items.size(); i = next++)
+		{
+			local.DoMove(rootMoves[items[i].root]);
+			local.DoMove(items[i].move);
+			counts[items[i].root] += (table != nullptr ? Perft(local, depth - 2, *table) : Perft(local, depth - 2));
+			local.UndoMove();
+			local.UndoMove();
+		}
+	};
+
+	vector<thread> pool;
+	for (int i = 1; i < threads; i++)
+		pool.emplace_back(worker);
+	worker();
+	for (thread& t : pool)
+		t.join();
+
+	for (int i = 0; i < rootMoves.Size(); i++)
+		res[i].second = counts[i];
+	return res;
+}
+
+long long ParallelPerft(const ChessPosition& position, int depth, int threads, PerftTable* table)
+{
+	if (depth == 0)
+		return 1;
+
+	long long nodes = 0;
+	for (auto& [move, count] : ParallelDivide(position, depth, threads, table))
+		nodes += count;
+	return nodes;
+}
\ No newline at end of file
@@ -1,6 +1,5 @@
 #pragma once
 
-#include <vector>
 #include <string>
 
 #include "Coords.h"
@@ -11,6 +10,10 @@ using namespace std;
 
 class ChessBoard;
 
+/*
+* View of a piece for the GUI and the move record
+* The position itself is kept by ChessPosition, moves are generated there
+*/
 class Piece
 {
 protected:
@@ -19,35 +22,19 @@ protected:
 
 	const ChessBoard* board;
 
-	vector<Position> possibleMoves;
-	vector<Position> visible;
-
 	bool moved;
 public:
 	Piece(Position pos, PlayerTeam team, const ChessBoard* board) :
 		pos(pos), team(team), board(board),
-		possibleMoves(), visible(),
 		moved(false)
 	{}
 
 	virtual ~Piece() {}
 
 
-	virtual void Update() = 0; // Updates possibleMoves and visible
-
-
 	virtual string GetName() const = 0;
 	virtual PieceType GetType() const = 0;
 
-	virtual const vector<Position>& GetMoves() const
-	{
-		return possibleMoves;
-	}
-	virtual const vector<Position>& GetVisible() const
-	{
-		return visible;
-	}
-
 	Position GetPosition() const
 	{
 		return pos;
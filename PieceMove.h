@@ -7,6 +7,7 @@
 #include "Coords.h"
 #include "Other.h"
 #include "Piece.h"
+#include "PackedMove.h"
 
 using namespace std;
 
@@ -16,12 +17,11 @@ struct PieceMove
 	PieceMove() : 
 		type(), 
 		captured(nullptr), 
-		check(false), mate(false), 
 		movedBefore(false), 
 		piece(), 
 		from(), to(), 
 		promoted(nullptr), 
-		notation()
+		packed(PackedMove::None())
 	{}
 
 	enum class MoveType
@@ -37,7 +37,6 @@ struct PieceMove
 	MoveType type;
 
 	Piece* captured;
-	bool check, mate;
 	bool movedBefore;
 
 	Piece* piece;
@@ -45,5 +44,5 @@ struct PieceMove
 
 	Piece* promoted;
 
-	string notation;
+	PackedMove packed; // the same move for ChessPosition, notation is written from it by ChessBoard::GetNotation
 };
\ No newline at end of file
@@ -0,0 +1,339 @@
+#pragma once
+
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <memory>
+
+#include "ChessPosition.h"
+#include "PackedMove.h"
+#include "Evaluation.h"
+#include "TranspositionTable.h"
+#include "MovePicker.h"
+
+using namespace std;
+
+
+const int INFINITE_SCORE = 32000;
+const int MATE_SCORE = 31000;		// mate in n plies is MATE_SCORE - n
+const int MAX_SEARCH_DEPTH = 64;
+static_assert(MAX_SEARCH_DEPTH < MoveHistory::MAX_PLY, "killers are kept for every ply");
+
+bool IsMateScore(int score)
+{
+	return abs(score) >= MATE_SCORE - MAX_SEARCH_DEPTH;
+}
+
+// Mate scores count plies from the root, the table keeps them counted from the position itself
+int ScoreToTable(int score, int ply)
+{
+	if (!IsMateScore(score))
+		return score;
+	return (score > 0 ? score + ply : score - ply);
+}
+int ScoreFromTable(int score, int ply)
+{
+	if (!IsMateScore(score))
+		return score;
+	return (score > 0 ? score - ply : score + ply);
+}
+
+// When to stop searching, 0 means no limit; with several threads the nodes are those of the main one
+struct SearchLimits
+{
+	int depth = MAX_SEARCH_DEPTH;
+	long long nodes = 0;
+	int milliseconds = 0;
+};
+
+// What the last fully searched depth found
+struct SearchResult
+{
+	PackedMove bestMove = PackedMove::None();	// None if there are no legal moves
+	int score = 0;								// centipawns for the side to move, see MATE_SCORE
+	int depth = 0;
+	long long nodes = 0;						// of all threads
+	vector<long long> threadNodes;				// by thread, the main one first
+	vector<PackedMove> pv;						// principal variation, starts with bestMove
+};
+
+
+/*
+* Iterative deepening principal variation search
+* Works on its own copy of the position, so the board it came from can be used meanwhile
+* and nothing from the GUI is needed
+* The transposition table is owned by the caller and may be shared with other searchers
+*/
+class Searcher
+{
+	ChessPosition position;
+	TranspositionTable* table;	// may be null to search without it
+	const atomic<bool>* stopSignal;	// set by another thread to end the search, may be null
+	SearchLimits limits;
+	chrono::steady_clock::time_point start;
+	long long nodes;
+	bool stopped;
+	bool canStop;		// the first depth is always finished, so there is a move to return
+
+	// triangular table, pv[ply] is the best line found from ply on
+	PackedMove pv[MAX_SEARCH_DEPTH + 1][MAX_SEARCH_DEPTH + 1];
+	int pvLength[MAX_SEARCH_DEPTH + 1];
+
+	void CheckLimits()
+	{
+		if (stopSignal != nullptr && stopSignal->load(memory_order_relaxed))
+			stopped = true;
+		if (!canStop)
+			return;
+		if (limits.nodes > 0 && nodes >= limits.nodes)
+			stopped = true;
+		// the clock is only read every 1024 nodes
+		else if (limits.milliseconds > 0 && (nodes & 1023) == 0 &&
+			chrono::steady_clock::now() - start >= chrono::milliseconds(limits.milliseconds))
+			stopped = true;
+	}
+
+	MoveHistory history;
+
+	/*
+	* Searches captures only until the position is quiet, so a leaf isn't scored in the middle of an exchange
+	* The side to move may stand pat on the evaluation instead, captures that lose material by SEE are skipped
+	* In check every evasion is searched, since standing pat isn't an option, and having none is mate;
+	* a stalemate isn't looked for, standing pat scores it well enough
+	*/
+	int Quiescence(int ply, int alpha, int beta)
+	{
+		pvLength[ply] = ply;
+
+		nodes++;
+		CheckLimits();
+		if (stopped)
+			return 0;
+
+		if (ply >= MAX_SEARCH_DEPTH)
+			return Evaluate(position);
+
+		const bool inCheck = position.IsCheck();
+		if (!inCheck)
+		{
+			int standPat = Evaluate(position);
+			if (standPat >= beta)
+				return beta;
+			alpha = max(alpha, standPat);
+		}
+
+		MovePicker picker(position, PackedMove::None(), history, ply, !inCheck);
+		int searched = 0;
+		for (PackedMove move = picker.Next(); !move.IsNone(); move = picker.Next())
+		{
+			searched++;
+			position.DoMove(move);
+			int score = -Quiescence(ply + 1, -beta, -alpha);
+			position.UndoMove();
+			if (stopped)
+				return 0;
+
+			if (score > alpha)
+			{
+				alpha = score;
+
+				pv[ply][ply] = move;
+				for (int j = ply + 1; j < pvLength[ply + 1]; j++)
+					pv[ply][j] = pv[ply + 1][j];
+				pvLength[ply] = pvLength[ply + 1];
+
+				if (alpha >= beta)
+					break;
+			}
+		}
+		if (inCheck && searched == 0)
+			return -MATE_SCORE + ply;
+		return alpha;
+	}
+
+	int AlphaBeta(int depth, int ply, int alpha, int beta, bool onPv, const vector<PackedMove>& previousPv)
+	{
+		pvLength[ply] = ply;
+
+		if (ply > 0 && (position.IsRepetition() || position.GetRule50() >= 100))
+			return 0;
+
+		// quiescence counts the node itself
+		if (depth <= 0 || ply >= MAX_SEARCH_DEPTH)
+			return Quiescence(ply, alpha, beta);
+
+		nodes++;
+		CheckLimits();
+		if (stopped)
+			return 0;
+
+		// the table only ends the search off the principal variation, so the whole line is still found
+		const bool pvNode = (beta - alpha > 1);
+		TranspositionTable::Hit hit;
+		hit.move = PackedMove::None();
+		if (table != nullptr && table->Probe(position.GetKey(), hit) && ply > 0 && !pvNode && hit.depth >= depth)
+		{
+			int score = ScoreFromTable(hit.score, ply);
+			if (hit.bound == TranspositionTable::Bound::Exact ||
+				(hit.bound == TranspositionTable::Bound::Lower && score >= beta) ||
+				(hit.bound == TranspositionTable::Bound::Upper && score <= alpha))
+				return min(max(score, alpha), beta);
+		}
+
+		// on the last principal variation its move goes first, elsewhere the one stored for the position
+		PackedMove hashMove = (onPv && ply < (int)previousPv.size() ? previousPv[ply] : hit.move);
+		MovePicker picker(position, hashMove, history, ply);
+
+		const int originalAlpha = alpha;
+		PackedMove bestMove = PackedMove::None();
+
+		int searched = 0;
+		for (PackedMove move = picker.Next(); !move.IsNone(); move = picker.Next())
+		{
+			bool quiet = !IsCaptureOrPromotion(position, move);
+			bool childOnPv = (onPv && ply < (int)previousPv.size() && move == previousPv[ply]);
+			position.DoMove(move);
+
+			// the first move gets the full window, the rest are only checked to be worse than it
+			int score;
+			if (searched++ == 0)
+				score = -AlphaBeta(depth - 1, ply + 1, -beta, -alpha, childOnPv, previousPv);
+			else
+			{
+				score = -AlphaBeta(depth - 1, ply + 1, -alpha - 1, -alpha, false, previousPv);
+				if (score > alpha && score < beta)
+					score = -AlphaBeta(depth - 1, ply + 1, -beta, -alpha, false, previousPv);
+			}
+
+			position.UndoMove();
+			if (stopped)
+				return 0;
+
+			if (score > alpha)
+			{
+				alpha = score;
+				bestMove = move;
+
+				pv[ply][ply] = move;
+				for (int j = ply + 1; j < pvLength[ply + 1]; j++)
+					pv[ply][j] = pv[ply + 1][j];
+				pvLength[ply] = pvLength[ply + 1];
+
+				if (alpha >= beta)
+				{
+					if (quiet)
+						history.AddCutoff(position.GetTurn(), move, ply, depth);
+					break;
+				}
+			}
+		}
+		if (searched == 0)
+			return (position.IsCheck() ? -MATE_SCORE + ply : 0);
+
+		if (table != nullptr)
+		{
+			TranspositionTable::Bound bound = (alpha >= beta ? TranspositionTable::Bound::Lower :
+				alpha > originalAlpha ? TranspositionTable::Bound::Exact : TranspositionTable::Bound::Upper);
+			table->Store(position.GetKey(), bestMove, ScoreToTable(alpha, ply), depth, bound);
+		}
+		return alpha;
+	}
+
+	// Iterative deepening from firstDepth on, the table must already be set up for this search
+	SearchResult Iterate(const BoardState& root, const SearchLimits& limits, int firstDepth)
+	{
+		position.SetSnapshot(root);
+		this->limits = limits;
+		start = chrono::steady_clock::now();
+		nodes = 0;
+		stopped = false;
+		canStop = false;
+		history.Clear();
+
+		SearchResult res;
+		for (int depth = firstDepth; depth <= min(limits.depth, MAX_SEARCH_DEPTH); depth++)
+		{
+			int score = AlphaBeta(depth, 0, -INFINITE_SCORE, INFINITE_SCORE, true, res.pv);
+			if (stopped)
+				break;
+			canStop = true;
+
+			res.score = score;
+			res.depth = depth;
+			res.pv.assign(pv[0], pv[0] + pvLength[0]);
+			res.bestMove = (res.pv.empty() ? PackedMove::None() : res.pv[0]);
+
+			if (res.bestMove.IsNone() || (IsMateScore(score) && MATE_SCORE - abs(score) <= depth))
+				break; // no moves, or a mate that deeper search can't change
+		}
+		res.nodes = nodes;
+		res.threadNodes = { nodes };
+		return res;
+	}
+public:
+	explicit Searcher(TranspositionTable* table = nullptr, const atomic<bool>* stopSignal = nullptr) :
+		position(), table(table), stopSignal(stopSignal), limits(), nodes(0), stopped(false), canStop(false)
+	{}
+
+	/*
+	* Searches root one depth at a time until a limit is reached, see SearchLimits
+	* Moves made before root aren't known, so repetitions are only found within the search
+	*/
+	SearchResult Search(const BoardState& root, const SearchLimits& limits)
+	{
+		if (table != nullptr)
+			table->NewSearch();
+		return Iterate(root, limits, 1);
+	}
+
+	long long GetNodes() const
+	{
+		return nodes;
+	}
+
+	friend SearchResult ParallelSearch(const BoardState& root, const SearchLimits& limits, int threads, TranspositionTable* table);
+};
+
+
+/*
+* Lazy SMP: every thread runs the same search on its own copy of the position, they share only the table
+* Helpers start one ply deeper every other thread, so they fill the table ahead of the main thread
+* and cut its work; the result is the main thread's, helpers are stopped when it is done
+* table may be null, but then helpers only repeat the main search
+*/
+SearchResult ParallelSearch(const BoardState& root, const SearchLimits& limits, int threads, TranspositionTable* table)
+{
+	if (table != nullptr)
+		table->NewSearch();
+
+	atomic<bool> stop = false;
+	vector<unique_ptr<Searcher> > helpers;
+	for (int i = 1; i < threads; i++)
+		helpers.emplace_back(new Searcher(table, &stop));
+
+	SearchLimits helperLimits;
+	helperLimits.depth = limits.depth;
+
+	vector<thread> pool;
+	for (int i = 0; i < (int)helpers.size(); i++)
+		pool.emplace_back([&, i]()
+		{
+			helpers[i]->Iterate(root, helperLimits, 1 + (i + 1) % 2);
+		});
+
+	Searcher main(table);
+	SearchResult res = main.Iterate(root, limits, 1);
+
+	stop = true;
+	for (thread& t : pool)
+		t.join();
+
+	for (const unique_ptr<Searcher>& helper : helpers)
+	{
+		res.threadNodes.push_back(helper->GetNodes());
+		res.nodes += helper->GetNodes();
+	}
+	return res;
+}
\ No newline at end of file
@@ -0,0 +1,164 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+#include "PackedMove.h"
+#include "AtomicEntry.h"
+
+using namespace std;
+
+
+/*
+* Results of searched positions by Zobrist key, shared by all search threads without locks, see AtomicEntry
+* An entry's data is move (16) | score (16) | depth (8) | bound (2) | age (6)
+* Four entries make a 64-byte bucket, so a probe reads one cache line
+*/
+class TranspositionTable
+{
+public:
+	enum class Bound
+	{
+		None,
+		Exact,
+		Lower,	// score is at least this, the search failed high
+		Upper	// score is at most this, no move raised alpha
+	};
+
+	struct Hit
+	{
+		PackedMove move;
+		int score;
+		int depth;
+		Bound bound;
+	};
+private:
+	static const int BUCKET_SIZE = 4;
+	struct alignas(64) Bucket
+	{
+		AtomicEntry entries[BUCKET_SIZE];
+	};
+	static_assert(sizeof(Bucket) == 64, "a bucket must fill one cache line");
+
+	vector<Bucket> buckets;
+	uint64_t mask;
+	uint8_t age;	// searches since the table was cleared, older entries are replaced first
+
+	static uint64_t Pack(PackedMove move, int score, int depth, Bound bound, int age)
+	{
+		return (uint64_t)move.GetData() | ((uint64_t)(uint16_t)(int16_t)score << 16) |
+			((uint64_t)(uint8_t)depth << 32) | ((uint64_t)bound << 40) | ((uint64_t)(age & 63) << 42);
+	}
+	static PackedMove DataMove(uint64_t data)
+	{
+		return PackedMove::FromData((uint16_t)data);
+	}
+	static int DataScore(uint64_t data)
+	{
+		return (int16_t)(uint16_t)(data >> 16);
+	}
+	static int DataDepth(uint64_t data)
+	{
+		return (uint8_t)(data >> 32);
+	}
+	static Bound DataBound(uint64_t data)
+	{
+		return Bound((data >> 40) & 3);
+	}
+	static int DataAge(uint64_t data)
+	{
+		return (int)(data >> 42) & 63;
+	}
+public:
+	explicit TranspositionTable(size_t megabytes) : buckets(), mask(0), age(0)
+	{
+		size_t count = 1;
+		while (count * 2 * sizeof(Bucket) <= megabytes * 1024 * 1024)
+			count *= 2;
+		buckets = vector<Bucket>(count);
+		mask = count - 1;
+		Clear();
+	}
+	TranspositionTable(const TranspositionTable&) = delete;
+	TranspositionTable& operator= (const TranspositionTable&) = delete;
+
+	void Clear()
+	{
+		for (Bucket& b : buckets)
+			for (AtomicEntry& e : b.entries)
+				e.Clear();
+		age = 0;
+	}
+	// Called before every search, so entries of earlier ones give way to new ones
+	void NewSearch()
+	{
+		age = (age + 1) & 63;
+	}
+
+	bool Probe(uint64_t key, Hit& hit) const
+	{
+		const Bucket& b = buckets[key & mask];
+		for (const AtomicEntry& e : b.entries)
+		{
+			uint64_t data;
+			if (!e.Load(key, data) || DataBound(data) == Bound::None)
+				continue;
+
+			hit.move = DataMove(data);
+			hit.score = DataScore(data);
+			hit.depth = DataDepth(data);
+			hit.bound = DataBound(data);
+			return true;
+		}
+		return false;
+	}
+
+	/*
+	* Keeps the result in the entry of the same key, otherwise in place of the least useful one in the bucket,
+	* the shallowest, counting every search it is old as another ply less
+	*/
+	void Store(uint64_t key, PackedMove move, int score, int depth, Bound bound)
+	{
+		Bucket& b = buckets[key & mask];
+
+		AtomicEntry* replace = &b.entries[0];
+		int worst = INT32_MAX;
+		for (AtomicEntry& e : b.entries)
+		{
+			uint64_t data;
+			if (e.Load(key, data))
+			{
+				// a deeper result of the same search is kept, unless this one is exact
+				if (bound != Bound::Exact && DataAge(data) == age && depth < DataDepth(data))
+					return;
+				if (move.IsNone())
+					move = DataMove(data); // keep the move to search first
+				replace = &e;
+				break;
+			}
+
+			int value = DataDepth(data) - ((age - DataAge(data)) & 63) * 8;
+			if (value < worst)
+			{
+				worst = value;
+				replace = &e;
+			}
+		}
+
+		replace->Store(key, Pack(move, score, depth, bound, age));
+	}
+
+	// Permille of entries written by the current search, sampled from the first buckets
+	int Usage() const
+	{
+		int used = 0, total = 0;
+		for (size_t i = 0; i < buckets.size() && total < 1000; i++)
+			for (const AtomicEntry& e : buckets[i].entries)
+			{
+				uint64_t data = e.GetData();
+				used += (DataBound(data) != Bound::None && DataAge(data) == age);
+				total++;
+			}
+		return used * 1000 / total;
+	}
+};
\ No newline at end of file
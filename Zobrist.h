@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+
+#include "Other.h"
+
+using namespace std;
+
+
+/*
+* Random keys for Zobrist hashing, a position key is XOR of the keys of everything in it
+* InitZobrist() must be called before any of them is used (ChessPosition does it)
+*/
+
+uint64_t ZOBRIST_PIECES[2][(int)PieceType::Count][64];	// [team][type][square]
+uint64_t ZOBRIST_CASTLING[16];							// [castling rights]
+uint64_t ZOBRIST_EP_FILE[8];							// file of the en passant square
+uint64_t ZOBRIST_BLACK_TURN;
+
+uint64_t ZobristPiece(PlayerTeam team, PieceType type, int square)
+{
+	return ZOBRIST_PIECES[(int)team][(int)type][square];
+}
+uint64_t ZobristCastling(int rights)
+{
+	return ZOBRIST_CASTLING[rights];
+}
+uint64_t ZobristEp(int square) // 0 if there is no en passant square
+{
+	return (square == -1 ? 0 : ZOBRIST_EP_FILE[square % 8]);
+}
+
+// Fixed seed, so keys are the same on every run
+bool BuildZobrist()
+{
+	uint64_t seed = 1070372;
+	auto random = [&]()
+	{
+		seed ^= seed >> 12, seed ^= seed << 25, seed ^= seed >> 27;
+		return seed * 2685821657736338717ULL;
+	};
+
+	for (int t = 0; t < 2; t++)
+		for (int i = 0; i < (int)PieceType::Count; i++)
+			for (int sq = 0; sq < 64; sq++)
+				ZOBRIST_PIECES[t][i][sq] = random();
+
+	for (int i = 0; i < 16; i++)
+		ZOBRIST_CASTLING[i] = random();
+
+	for (int f = 0; f < 8; f++)
+		ZOBRIST_EP_FILE[f] = random();
+
+	ZOBRIST_BLACK_TURN = random();
+
+	return true;
+}
+
+void InitZobrist()
+{
+	static const bool initialized = BuildZobrist(); // thread-safe, runs once
+	(void)initialized;
+}
\ No newline at end of file